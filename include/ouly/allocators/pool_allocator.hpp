@@ -65,7 +65,7 @@ public:
   template <typename Alignment = alignment<>>
   [[nodiscard]] auto allocate(size_type size_value, Alignment alignment = {}) -> address
   {
-    constexpr auto alignment_value = (size_t)alignment;
+    constexpr auto alignment_value = static_cast<size_t>(alignment);
     auto           fixup           = alignment_value - 1;
     if (alignment_value && ((k_atom_size_ < alignment_value) || (k_atom_size_ & fixup)))
     {
@@ -118,7 +118,7 @@ public:
   template <typename Alignment = alignment<>>
   void deallocate(address i_ptr, size_type size_value, Alignment alignment = {})
   {
-    constexpr auto alignment_value = (size_t)alignment;
+    constexpr auto alignment_value = static_cast<size_t>(alignment);
     auto           fixup           = alignment_value - 1;
     address        orig_ptr        = i_ptr;
     if (alignment_value && ((k_atom_size_ < alignment_value) || (k_atom_size_ & fixup)))
@@ -194,36 +194,36 @@ private:
     auto length() const -> size_type
     {
       // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-      return *reinterpret_cast<size_type*>(ivalue_ & ~0x1);
+      return *reinterpret_cast<size_type*>(ivalue_ & ~std::uintptr_t{1});
     }
 
     void set_length(size_type i_length)
     {
       // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-      *reinterpret_cast<size_type*>(ivalue_ & ~0x1) = i_length;
+      *reinterpret_cast<size_type*>(ivalue_ & ~std::uintptr_t{1}) = i_length;
     }
 
     auto get_next() const -> array_arena
     {
       // NOLINTNEXTLINE
-      return *(reinterpret_cast<void**>(ivalue_ & ~0x1) + 1);
+      return *(reinterpret_cast<void**>(ivalue_ & ~std::uintptr_t{1}) + 1);
     }
 
     void set_next(array_arena next)
     {
       // NOLINTNEXTLINE
-      *(reinterpret_cast<void**>(ivalue_ & ~0x1) + 1) = next.value_;
+      *(reinterpret_cast<void**>(ivalue_ & ~std::uintptr_t{1}) + 1) = next.value_;
     }
 
     void clear_flag()
     {
-      ivalue_ &= (~0x1);
+      ivalue_ &= ~std::uintptr_t{1};
     }
 
     [[nodiscard]] auto get_value() const -> std::uint8_t*
     {
       // NOLINTNEXTLINE
-      return reinterpret_cast<std::uint8_t*>(ivalue_ & ~0x1);
+      return reinterpret_cast<std::uint8_t*>(ivalue_ & ~std::uintptr_t{1});
     }
     auto update(size_type i_count) -> void*
     {
@@ -0,0 +1,429 @@
+#pragma once
+
+#include "ouly/scheduler/scheduler.hpp"
+#include "ouly/scheduler/spin_lock.hpp"
+#include <coroutine>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace ouly
+{
+
+namespace detail
+{
+/**
+ * @brief A suspended coroutine waiting on an async primitive, lives in the awaiter inside the coroutine frame
+ */
+struct async_waiter
+{
+  async_waiter* next_      = nullptr;
+  void*         coroutine_ = nullptr;
+  workgroup_id  group_     = default_workgroup_id;
+  // Waits for shared ownership of an async_shared_mutex
+  bool shared_ = false;
+};
+
+/**
+ * @brief Intrusive FIFO of waiters, guarded by the lock of the primitive that owns it
+ */
+class async_wait_list
+{
+public:
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return head_ == nullptr;
+  }
+
+  [[nodiscard]] auto front() const noexcept -> async_waiter*
+  {
+    return head_;
+  }
+
+  void push_back(async_waiter& waiter) noexcept
+  {
+    waiter.next_ = nullptr;
+    if (tail_ != nullptr)
+    {
+      tail_->next_ = &waiter;
+    }
+    else
+    {
+      head_ = &waiter;
+    }
+    tail_ = &waiter;
+  }
+
+  auto pop_front() noexcept -> async_waiter*
+  {
+    auto* waiter = head_;
+    if (waiter != nullptr)
+    {
+      head_ = waiter->next_;
+      if (head_ == nullptr)
+      {
+        tail_ = nullptr;
+      }
+      waiter->next_ = nullptr;
+    }
+    return waiter;
+  }
+
+  /**
+   * @brief Detach all waiters, returns the first one of the chain
+   */
+  auto take_all() noexcept -> async_waiter*
+  {
+    auto* waiters = head_;
+    head_         = nullptr;
+    tail_         = nullptr;
+    return waiters;
+  }
+
+private:
+  async_waiter* head_ = nullptr;
+  async_waiter* tail_ = nullptr;
+};
+
+/**
+ * @brief Resume a chain of waiters linked through next_, every coroutine is submitted to the workgroup it waits for
+ */
+OULY_API void resume_waiters(scheduler& s, async_waiter* waiters) noexcept;
+
+/**
+ * @brief Awaiter shared by the primitives, the coroutine continues inline when the primitive is available and is
+ * queued otherwise. Result is constructed from the primitive on resumption, ie. a lock guard.
+ */
+template <typename Sync, typename Result = void>
+class async_wait_awaiter
+{
+public:
+  async_wait_awaiter(Sync& sync, workgroup_id group, bool shared = false) noexcept : sync_(&sync)
+  {
+    waiter_.group_  = group;
+    waiter_.shared_ = shared;
+  }
+
+  [[nodiscard]] auto await_ready() noexcept -> bool
+  {
+    return sync_->try_acquire_for(waiter_);
+  }
+
+  auto await_suspend(std::coroutine_handle<> awaiting_coro) noexcept -> bool
+  {
+    waiter_.coroutine_ = awaiting_coro.address();
+    // False when the primitive became available meanwhile
+    return sync_->enqueue(waiter_);
+  }
+
+  auto await_resume() const noexcept -> Result
+  {
+    if constexpr (!std::is_void_v<Result>)
+    {
+      return Result(*sync_);
+    }
+  }
+
+private:
+  Sync*        sync_ = nullptr;
+  async_waiter waiter_;
+};
+
+/**
+ * @brief Lock and waiter queue common to the primitives
+ */
+class async_sync_base
+{
+public:
+  explicit async_sync_base(scheduler& s) noexcept : scheduler_(&s) {}
+
+protected:
+  scheduler*              scheduler_ = nullptr;
+  mutable ouly::spin_lock lock_;
+  async_wait_list         waiters_;
+};
+} // namespace detail
+
+/**
+ * @brief Owns an async mutex, or shared ownership of an async_shared_mutex, until it is destroyed
+ */
+template <typename Mutex, bool Shared = false>
+class async_lock_guard
+{
+public:
+  explicit async_lock_guard(Mutex& mutex) noexcept : mutex_(&mutex) {}
+  async_lock_guard(async_lock_guard const&) = delete;
+  async_lock_guard(async_lock_guard&& other) noexcept : mutex_(std::exchange(other.mutex_, nullptr)) {}
+  auto operator=(async_lock_guard const&) -> async_lock_guard& = delete;
+  auto operator=(async_lock_guard&&) -> async_lock_guard&      = delete;
+
+  ~async_lock_guard() noexcept
+  {
+    if (mutex_ != nullptr)
+    {
+      if constexpr (Shared)
+      {
+        mutex_->unlock_shared();
+      }
+      else
+      {
+        mutex_->unlock();
+      }
+    }
+  }
+
+private:
+  Mutex* mutex_ = nullptr;
+};
+
+/**
+ * @brief Mutex for coroutines, a coroutine that finds it locked is suspended instead of blocking its worker.
+ *
+ * Waiters are queued in FIFO order inside their coroutine frames. unlock hands the mutex directly to the first waiter
+ * and submits it to the workgroup it asked to be resumed on, so a released mutex cannot be taken over by a newcomer
+ * while the waiter is on its way.
+ *
+ * @code
+ * ouly::async_mutex cache_lock(scheduler);
+ * auto update = [&]() -> ouly::co_task<void>
+ * {
+ *   auto guard = co_await cache_lock.scoped_lock();
+ *   cache.insert(...);
+ * };
+ * @endcode
+ */
+class async_mutex : detail::async_sync_base
+{
+public:
+  using awaiter        = detail::async_wait_awaiter<async_mutex>;
+  using scoped_awaiter = detail::async_wait_awaiter<async_mutex, async_lock_guard<async_mutex>>;
+
+  explicit async_mutex(scheduler& s) noexcept : async_sync_base(s) {}
+  async_mutex(async_mutex const&)                    = delete;
+  async_mutex(async_mutex&&)                         = delete;
+  auto operator=(async_mutex const&) -> async_mutex& = delete;
+  auto operator=(async_mutex&&) -> async_mutex&      = delete;
+  ~async_mutex() noexcept                            = default;
+
+  /**
+   * @brief Await ownership, a coroutine that had to wait is resumed on a worker of group
+   */
+  [[nodiscard]] auto lock(workgroup_id group = default_workgroup_id) noexcept -> awaiter
+  {
+    return {*this, group};
+  }
+
+  /**
+   * @brief Await ownership, returns a guard that unlocks the mutex
+   */
+  [[nodiscard]] auto scoped_lock(workgroup_id group = default_workgroup_id) noexcept -> scoped_awaiter
+  {
+    return {*this, group};
+  }
+
+  [[nodiscard]] OULY_API auto try_lock() noexcept -> bool;
+  OULY_API void               unlock() noexcept;
+
+private:
+  template <typename, typename>
+  friend class detail::async_wait_awaiter;
+
+  auto try_acquire_for(detail::async_waiter const& /*unused*/) noexcept -> bool
+  {
+    return try_lock();
+  }
+
+  OULY_API auto enqueue(detail::async_waiter& waiter) noexcept -> bool;
+
+  bool locked_ = false;
+};
+
+/**
+ * @brief Reader writer mutex for coroutines
+ *
+ * Any number of coroutines can share ownership while no coroutine owns it exclusively. A queued exclusive waiter stops
+ * new shared owners from getting in, so writers are not starved. Releasing the exclusive lock resumes either the first
+ * exclusive waiter or all shared waiters queued before the next exclusive one.
+ */
+class async_shared_mutex : detail::async_sync_base
+{
+public:
+  using awaiter               = detail::async_wait_awaiter<async_shared_mutex>;
+  using scoped_awaiter        = detail::async_wait_awaiter<async_shared_mutex, async_lock_guard<async_shared_mutex>>;
+  using scoped_shared_awaiter =
+   detail::async_wait_awaiter<async_shared_mutex, async_lock_guard<async_shared_mutex, true>>;
+
+  explicit async_shared_mutex(scheduler& s) noexcept : async_sync_base(s) {}
+  async_shared_mutex(async_shared_mutex const&)                    = delete;
+  async_shared_mutex(async_shared_mutex&&)                         = delete;
+  auto operator=(async_shared_mutex const&) -> async_shared_mutex& = delete;
+  auto operator=(async_shared_mutex&&) -> async_shared_mutex&      = delete;
+  ~async_shared_mutex() noexcept                                   = default;
+
+  [[nodiscard]] auto lock(workgroup_id group = default_workgroup_id) noexcept -> awaiter
+  {
+    return {*this, group};
+  }
+
+  [[nodiscard]] auto lock_shared(workgroup_id group = default_workgroup_id) noexcept -> awaiter
+  {
+    return {*this, group, true};
+  }
+
+  [[nodiscard]] auto scoped_lock(workgroup_id group = default_workgroup_id) noexcept -> scoped_awaiter
+  {
+    return {*this, group};
+  }
+
+  [[nodiscard]] auto scoped_lock_shared(workgroup_id group = default_workgroup_id) noexcept -> scoped_shared_awaiter
+  {
+    return {*this, group, true};
+  }
+
+  [[nodiscard]] OULY_API auto try_lock() noexcept -> bool;
+  [[nodiscard]] OULY_API auto try_lock_shared() noexcept -> bool;
+  OULY_API void               unlock() noexcept;
+  OULY_API void               unlock_shared() noexcept;
+
+private:
+  template <typename, typename>
+  friend class detail::async_wait_awaiter;
+
+  auto try_acquire_for(detail::async_waiter const& waiter) noexcept -> bool
+  {
+    return waiter.shared_ ? try_lock_shared() : try_lock();
+  }
+
+  OULY_API auto enqueue(detail::async_waiter& waiter) noexcept -> bool;
+  // Called with the lock held
+  auto acquire_locked(bool shared) noexcept -> bool;
+
+  uint32_t readers_ = 0;
+  bool     writer_  = false;
+};
+
+/**
+ * @brief Counting semaphore for coroutines, acquire suspends while the count is 0
+ *
+ * release hands its units to queued waiters first, in FIFO order.
+ */
+class async_semaphore : detail::async_sync_base
+{
+public:
+  using awaiter = detail::async_wait_awaiter<async_semaphore>;
+
+  async_semaphore(scheduler& s, uint32_t initial) noexcept : async_sync_base(s), count_(initial) {}
+  async_semaphore(async_semaphore const&)                    = delete;
+  async_semaphore(async_semaphore&&)                         = delete;
+  auto operator=(async_semaphore const&) -> async_semaphore& = delete;
+  auto operator=(async_semaphore&&) -> async_semaphore&      = delete;
+  ~async_semaphore() noexcept                                = default;
+
+  [[nodiscard]] auto acquire(workgroup_id group = default_workgroup_id) noexcept -> awaiter
+  {
+    return {*this, group};
+  }
+
+  [[nodiscard]] OULY_API auto try_acquire() noexcept -> bool;
+  OULY_API void               release(uint32_t count = 1) noexcept;
+
+  [[nodiscard]] OULY_API auto get_count() const noexcept -> uint32_t;
+
+private:
+  template <typename, typename>
+  friend class detail::async_wait_awaiter;
+
+  auto try_acquire_for(detail::async_waiter const& /*unused*/) noexcept -> bool
+  {
+    return try_acquire();
+  }
+
+  OULY_API auto enqueue(detail::async_waiter& waiter) noexcept -> bool;
+
+  uint32_t count_ = 0;
+};
+
+/**
+ * @brief Single use countdown for coroutines, waiters are resumed once the count reaches 0
+ */
+class async_latch : detail::async_sync_base
+{
+public:
+  using awaiter = detail::async_wait_awaiter<async_latch>;
+
+  async_latch(scheduler& s, uint32_t count) noexcept : async_sync_base(s), count_(count) {}
+  async_latch(async_latch const&)                    = delete;
+  async_latch(async_latch&&)                         = delete;
+  auto operator=(async_latch const&) -> async_latch& = delete;
+  auto operator=(async_latch&&) -> async_latch&      = delete;
+  ~async_latch() noexcept                            = default;
+
+  /**
+   * @brief Decrement the count, safe to call from any thread
+   */
+  OULY_API void count_down(uint32_t n = 1) noexcept;
+
+  [[nodiscard]] auto wait(workgroup_id group = default_workgroup_id) noexcept -> awaiter
+  {
+    return {*this, group};
+  }
+
+  [[nodiscard]] OULY_API auto try_wait() const noexcept -> bool;
+
+private:
+  template <typename, typename>
+  friend class detail::async_wait_awaiter;
+
+  auto try_acquire_for(detail::async_waiter const& /*unused*/) const noexcept -> bool
+  {
+    return try_wait();
+  }
+
+  OULY_API auto enqueue(detail::async_waiter& waiter) noexcept -> bool;
+
+  uint32_t count_ = 0;
+};
+
+/**
+ * @brief Manual reset event for coroutines, waiters are resumed when the event is set
+ */
+class async_event : detail::async_sync_base
+{
+public:
+  using awaiter = detail::async_wait_awaiter<async_event>;
+
+  explicit async_event(scheduler& s, bool set = false) noexcept : async_sync_base(s), set_(set) {}
+  async_event(async_event const&)                    = delete;
+  async_event(async_event&&)                         = delete;
+  auto operator=(async_event const&) -> async_event& = delete;
+  auto operator=(async_event&&) -> async_event&      = delete;
+  ~async_event() noexcept                            = default;
+
+  /**
+   * @brief Set the event and resume every waiter, safe to call from any thread
+   */
+  OULY_API void set() noexcept;
+  OULY_API void reset() noexcept;
+
+  [[nodiscard]] OULY_API auto is_set() const noexcept -> bool;
+
+  [[nodiscard]] auto wait(workgroup_id group = default_workgroup_id) noexcept -> awaiter
+  {
+    return {*this, group};
+  }
+
+private:
+  template <typename, typename>
+  friend class detail::async_wait_awaiter;
+
+  auto try_acquire_for(detail::async_waiter const& /*unused*/) const noexcept -> bool
+  {
+    return is_set();
+  }
+
+  OULY_API auto enqueue(detail::async_waiter& waiter) noexcept -> bool;
+
+  bool set_ = false;
+};
+
+} // namespace ouly
@@ -17,11 +17,23 @@ public:
   template <typename AwaiterPromise>
   void await_suspend(std::coroutine_handle<AwaiterPromise> awaiting_coro) noexcept
   {
-    ouly::detail::coro_state& state = awaiting_coro.promise();
+    complete(awaiting_coro.promise());
+  }
+
+  /**
+   * @brief Hand a finished coroutine over to whoever awaits it, or to its join
+   */
+  static void complete(ouly::detail::coro_state& state) noexcept
+  {
+    auto* join = state.join_.exchange(&ouly::detail::completed_join, std::memory_order_acq_rel);
     if (state.continuation_state_.exchange(true))
     {
       state.continuation_.resume();
     }
+    else if (join != nullptr)
+    {
+      join->arrive_(*join, state);
+    }
   }
 
   void await_resume() noexcept {}
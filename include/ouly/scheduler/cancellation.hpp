@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ouly/utility/config.hpp"
+#include <atomic>
+
+namespace ouly
+{
+
+class cancellation_source;
+
+/**
+ * @brief Read side of a cancellation_source, a trivially copyable pointer to the source's flag.
+ *
+ * Work submitted with a token is skipped by the worker that dequeues it once the source is cancelled, a co_task
+ * submitted with a token completes without running its body. Tasks can also poll is_cancelled to stop early, and pass
+ * the token on to the work they submit so a whole subtree is abandoned at once. A default constructed token is never
+ * cancelled.
+ */
+class cancellation_token
+{
+public:
+  constexpr cancellation_token() noexcept = default;
+
+  [[nodiscard]] auto is_cancelled() const noexcept -> bool
+  {
+    return flag_ != nullptr && flag_->load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] auto can_be_cancelled() const noexcept -> bool
+  {
+    return flag_ != nullptr;
+  }
+
+private:
+  friend class cancellation_source;
+
+  explicit cancellation_token(std::atomic_bool const* flag) noexcept : flag_(flag) {}
+
+  std::atomic_bool const* flag_ = nullptr;
+};
+
+/**
+ * @brief Owner of a cancellation flag, tokens point into the source so it must outlive all work bound to its tokens.
+ *
+ * @code
+ * ouly::cancellation_source query;
+ * scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, query.get_token(), [&state](auto const& ctx) {
+ * ... });
+ * // The result is stale, drop everything still queued
+ * query.cancel();
+ * @endcode
+ */
+class cancellation_source
+{
+public:
+  cancellation_source() noexcept                                     = default;
+  cancellation_source(cancellation_source const&)                    = delete;
+  cancellation_source(cancellation_source&&)                         = delete;
+  auto operator=(cancellation_source const&) -> cancellation_source& = delete;
+  auto operator=(cancellation_source&&) -> cancellation_source&      = delete;
+  ~cancellation_source() noexcept                                    = default;
+
+  /**
+   * @brief Request cancellation, work bound to the tokens and not yet started will not run
+   */
+  void cancel() noexcept
+  {
+    cancelled_.store(true, std::memory_order_release);
+  }
+
+  /**
+   * @brief Make the source usable again, ie. for the next frame. Only call once no work is bound to its tokens.
+   */
+  void reset() noexcept
+  {
+    cancelled_.store(false, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] auto is_cancelled() const noexcept -> bool
+  {
+    return cancelled_.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] auto get_token() const noexcept -> cancellation_token
+  {
+    return cancellation_token(&cancelled_);
+  }
+
+private:
+  // On its own cache line, tokens are read by every worker
+  alignas(ouly::cache_line_size) std::atomic_bool cancelled_ = false;
+};
+
+} // namespace ouly
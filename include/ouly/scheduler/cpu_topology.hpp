@@ -0,0 +1,110 @@
+#pragma once
+
+#include "ouly/utility/config.hpp"
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ouly
+{
+
+/**
+ * @brief Placement of a logical cpu in the machine
+ */
+struct cpu_info
+{
+  static constexpr uint32_t invalid = std::numeric_limits<uint32_t>::max();
+
+  // Logical cpu index as used by the OS
+  uint32_t cpu_ = invalid;
+  // Dense index of the physical core, SMT siblings share it
+  uint32_t core_ = invalid;
+  // Physical package (socket)
+  uint32_t package_ = invalid;
+  // NUMA node
+  uint32_t node_ = invalid;
+  // Dense index of the last level cache domain, cpus sharing an L3 share it
+  uint32_t l3_ = invalid;
+};
+
+/**
+ * @brief Snapshot of the machine's cpu topology, used to pin workers and to build workgroups out of physical cores.
+ *
+ * On Linux the topology is read from /sys/devices/system/cpu and /sys/devices/system/node. When these are not
+ * available every logical cpu reported by std::thread::hardware_concurrency is treated as its own core on node 0 with
+ * a single shared L3.
+ *
+ * @code
+ * auto topology = ouly::cpu_topology::detect();
+ * // One worker per physical core of node 0, the rest of the machine runs the default group
+ * auto cores = topology.get_physical_cores(0);
+ * scheduler.create_group(render_group, 0, topology, cores);
+ * @endcode
+ */
+class cpu_topology
+{
+public:
+  static constexpr uint32_t any_node = std::numeric_limits<uint32_t>::max();
+
+  cpu_topology() noexcept = default;
+  OULY_API explicit cpu_topology(std::vector<cpu_info> cpus);
+
+  /**
+   * @brief Read the topology of the current machine
+   * @param sysfs_root Root of the sysfs system directory, can be redirected for testing
+   */
+  OULY_API static auto detect(std::string_view sysfs_root = "/sys/devices/system") -> cpu_topology;
+
+  /**
+   * @brief Pin the calling thread to a logical cpu, returns false if the platform does not support it or it failed
+   */
+  OULY_API static auto pin_current_thread(uint32_t cpu) noexcept -> bool;
+
+  /**
+   * @brief Logical cpus sorted by cpu index
+   */
+  [[nodiscard]] auto get_cpus() const noexcept -> std::span<cpu_info const>
+  {
+    return cpus_;
+  }
+
+  /**
+   * @brief Find a logical cpu, returns nullptr if it is not online
+   */
+  [[nodiscard]] OULY_API auto find(uint32_t cpu) const noexcept -> cpu_info const*;
+
+  /**
+   * @brief One logical cpu per physical core, optionally restricted to a NUMA node
+   */
+  [[nodiscard]] OULY_API auto get_physical_cores(uint32_t node = any_node) const -> std::vector<uint32_t>;
+
+  /**
+   * @brief All logical cpus, optionally restricted to a NUMA node. SMT siblings are placed next to each other.
+   */
+  [[nodiscard]] OULY_API auto get_logical_cpus(uint32_t node = any_node) const -> std::vector<uint32_t>;
+
+  [[nodiscard]] auto get_node_count() const noexcept -> uint32_t
+  {
+    return node_count_;
+  }
+
+  [[nodiscard]] auto get_core_count() const noexcept -> uint32_t
+  {
+    return core_count_;
+  }
+
+  [[nodiscard]] auto get_l3_count() const noexcept -> uint32_t
+  {
+    return l3_count_;
+  }
+
+private:
+  std::vector<cpu_info> cpus_;
+  uint32_t              node_count_ = 0;
+  uint32_t              core_count_ = 0;
+  uint32_t              l3_count_   = 0;
+};
+
+} // namespace ouly
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ouly::detail
+{
+
+/**
+ * @brief Storage for one item of a ring that a thief reads while the owner may overwrite it.
+ *
+ * The item is copied in and out as relaxed atomic words, so a racing read yields a torn copy rather than undefined
+ * behaviour. Readers publish nothing they read before winning the index exchange that proves the slot was not reused,
+ * and drop the copy otherwise.
+ *
+ * @tparam T Item type, copied bytewise, so its copy must be a plain memcpy and its size a multiple of 4 bytes
+ */
+template <typename T>
+class atomic_slot
+{
+  static_assert(sizeof(T) % sizeof(std::uint32_t) == 0 && std::is_trivially_destructible_v<T> &&
+                 std::is_nothrow_default_constructible_v<T>,
+                "Atomic slot items must be a whole number of words, trivially destructible and default constructible");
+
+  using word_type = std::conditional_t<sizeof(T) % sizeof(std::uint64_t) == 0, std::uint64_t, std::uint32_t>;
+
+  static constexpr std::size_t word_count = sizeof(T) / sizeof(word_type);
+
+public:
+  void store(T const& item) noexcept
+  {
+    std::array<word_type, word_count> words;
+    std::memcpy(words.data(), static_cast<void const*>(&item), sizeof(T));
+    for (std::size_t i = 0; i < word_count; ++i)
+    {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]] auto load() const noexcept -> T
+  {
+    std::array<word_type, word_count> words;
+    for (std::size_t i = 0; i < word_count; ++i)
+    {
+      words[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    T item;
+    std::memcpy(static_cast<void*>(&item), words.data(), sizeof(T));
+    return item;
+  }
+
+private:
+  std::array<std::atomic<word_type>, word_count> words_{};
+};
+
+} // namespace ouly::detail
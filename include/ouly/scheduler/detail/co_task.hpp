@@ -49,7 +49,15 @@ public:
 
   [[nodiscard]] auto is_done() const noexcept -> bool
   {
-    return !coro_ || coro_.done();
+    return !coro_ || coro_.done() || coro_.promise().cancelled_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Check if the task was skipped because its cancellation_token was cancelled before it started
+   */
+  [[nodiscard]] auto is_cancelled() const noexcept -> bool
+  {
+    return coro_ && coro_.promise().cancelled_.load(std::memory_order_acquire);
   }
 
   [[nodiscard]] explicit operator bool() const noexcept
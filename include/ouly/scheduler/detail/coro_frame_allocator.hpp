@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ouly/utility/config.hpp"
+#include <cstddef>
+
+namespace ouly::detail
+{
+
+/**
+ * @brief Frame sizes served by the coroutine frame pools, larger frames go to the global operator new
+ */
+static constexpr std::size_t min_pooled_frame_size = 128;
+static constexpr std::size_t max_pooled_frame_size = 2048;
+
+/**
+ * @brief Allocate a coroutine frame from the calling thread's frame pool.
+ *
+ * Every thread lazily owns a set of size-class pools built on ouly::pool_allocator, so allocating and freeing a frame
+ * on the same thread is a free list push/pop without any synchronization. A frame freed by another thread is pushed on
+ * a lock-free list of its owning pool and reclaimed by the owner on its next allocation of that size class. Pools of
+ * exiting threads are parked and adopted by new threads, so frames can safely outlive the thread that created them.
+ */
+OULY_API auto allocate_coro_frame(std::size_t size) -> void*;
+
+/**
+ * @brief Release a coroutine frame allocated by allocate_coro_frame, size must match the allocated size
+ */
+OULY_API void deallocate_coro_frame(void* frame, std::size_t size) noexcept;
+
+} // namespace ouly::detail
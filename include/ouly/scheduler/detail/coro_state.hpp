@@ -5,9 +5,29 @@
 
 namespace ouly::detail
 {
+struct coro_state;
+
+/**
+ * @brief Join point of a when_all/when_any, a completed child arrives at its join instead of resuming a continuation
+ */
+struct coro_join
+{
+  using arrive_fn = void (*)(coro_join&, coro_state&) noexcept;
+  arrive_fn arrive_ = nullptr;
+};
+
+/**
+ * @brief Marker stored as the join of a completed coroutine
+ */
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+inline coro_join completed_join{};
+
 struct coro_state
 {
   std::coroutine_handle<> continuation_       = nullptr;
   std::atomic_bool        continuation_state_ = false;
+  std::atomic<coro_join*> join_               = nullptr;
+  // Completed through a cancellation_token without running, the result is value initialized
+  std::atomic_bool cancelled_ = false;
 };
-} // namespace ouly::detail
\ No newline at end of file
+} // namespace ouly::detail
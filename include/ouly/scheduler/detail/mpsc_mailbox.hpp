@@ -0,0 +1,184 @@
+#pragma once
+
+#include "ouly/utility/config.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ouly::detail
+{
+
+/**
+ * @brief Link of an mpsc_mailbox, carries the item and the index of the pool it came from
+ */
+template <typename T>
+struct mailbox_node
+{
+  std::atomic<mailbox_node*> next_ = nullptr;
+  T                          item_;
+  uint32_t                   owner_ = 0;
+};
+
+/**
+ * @brief Intrusive lock-free multi producer single consumer queue.
+ *
+ * Producers link a node in with a single exchange on the head, the consumer unlinks nodes from the tail without any
+ * atomic read-modify-write in the common case. A stub node is re-linked whenever the queue runs dry so the tail never
+ * has to be reset. The queue does not own its nodes.
+ *
+ * A producer that has exchanged the head but not yet linked its node briefly hides the nodes behind it, try_pop then
+ * fails while empty already reports the queue as not empty. The producer wakes the consumer up after it is done, so
+ * the node is seen on the consumer's next pass.
+ *
+ * Based on Dmitry Vyukov's intrusive MPSC node-based queue.
+ */
+template <typename T>
+class mpsc_mailbox
+{
+public:
+  using node = mailbox_node<T>;
+
+  mpsc_mailbox() noexcept                              = default;
+  mpsc_mailbox(mpsc_mailbox const&)                    = delete;
+  mpsc_mailbox(mpsc_mailbox&&)                         = delete;
+  auto operator=(mpsc_mailbox const&) -> mpsc_mailbox& = delete;
+  auto operator=(mpsc_mailbox&&) -> mpsc_mailbox&      = delete;
+  ~mpsc_mailbox() noexcept                             = default;
+
+  /**
+   * @brief Link a node in, safe to call from any thread
+   */
+  void push(node* n) noexcept
+  {
+    n->next_.store(nullptr, std::memory_order_relaxed);
+    node* prev = head_.exchange(n, std::memory_order_acq_rel);
+    prev->next_.store(n, std::memory_order_release);
+  }
+
+  /**
+   * @brief Unlink the oldest node, consumer only
+   * @return nullptr if the queue is empty, or the next node is still being linked in
+   */
+  auto try_pop() noexcept -> node*
+  {
+    node* tail = tail_;
+    node* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_)
+    {
+      if (next == nullptr)
+      {
+        return nullptr;
+      }
+      tail_ = next;
+      tail  = next;
+      next  = next->next_.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr)
+    {
+      tail_ = next;
+      return tail;
+    }
+
+    if (tail != head_.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+
+    // tail is the last node, put the stub behind it so it can be unlinked
+    push(&stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief True if nothing was pushed since the consumer last ran the queue dry, a single relaxed load safe to call
+   * from any thread
+   */
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return head_.load(std::memory_order_relaxed) == &stub_;
+  }
+
+private:
+  node stub_;
+  // Written by producers
+  alignas(ouly::cache_line_size) std::atomic<node*> head_ = &stub_;
+  // Consumer only
+  alignas(ouly::cache_line_size) node* tail_ = &stub_;
+};
+
+/**
+ * @brief Mailbox nodes owned by one producer.
+ *
+ * The owner takes nodes from a private free list, consumers give nodes back to the pool they came from by pushing them
+ * on a lock-free list that the owner takes over as a whole once its free list runs dry. Nodes are allocated in blocks,
+ * the pool stops allocating once it has grown to the number of nodes in flight.
+ */
+template <typename T>
+class mailbox_node_pool
+{
+public:
+  using node = mailbox_node<T>;
+
+  static constexpr uint32_t block_size = 64;
+
+  mailbox_node_pool() noexcept                                   = default;
+  mailbox_node_pool(mailbox_node_pool const&)                    = delete;
+  mailbox_node_pool(mailbox_node_pool&&)                         = delete;
+  auto operator=(mailbox_node_pool const&) -> mailbox_node_pool& = delete;
+  auto operator=(mailbox_node_pool&&) -> mailbox_node_pool&      = delete;
+  ~mailbox_node_pool() noexcept                                  = default;
+
+  /**
+   * @brief Get a free node, owner only
+   */
+  auto acquire(uint32_t owner) -> node*
+  {
+    if (free_ == nullptr)
+    {
+      free_ = returned_.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (free_ == nullptr)
+    {
+      auto& block = blocks_.emplace_back(std::make_unique<node[]>(block_size));
+      for (uint32_t i = 0; i < block_size; ++i)
+      {
+        block[i].owner_ = owner;
+        block[i].next_.store(i + 1 < block_size ? &block[i + 1] : nullptr, std::memory_order_relaxed);
+      }
+      free_ = block.get();
+    }
+    node* n = free_;
+    free_   = n->next_.load(std::memory_order_relaxed);
+    return n;
+  }
+
+  /**
+   * @brief Give a node back to the pool, safe to call from any thread
+   */
+  void release(node* n) noexcept
+  {
+    node* top = returned_.load(std::memory_order_relaxed);
+    do
+    {
+      n->next_.store(top, std::memory_order_relaxed);
+    }
+    while (!returned_.compare_exchange_weak(top, n, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+private:
+  // Owner only
+  std::vector<std::unique_ptr<node[]>> blocks_;
+  node*                                free_ = nullptr;
+  // Pushed by consumers, taken over as a whole by the owner so the list does not suffer from ABA
+  alignas(ouly::cache_line_size) std::atomic<node*> returned_ = nullptr;
+};
+
+} // namespace ouly::detail
@@ -1,8 +1,12 @@
 #pragma once
 
 #include "ouly/scheduler/scheduler.hpp"
+#include "ouly/scheduler/spin_lock.hpp"
 #include "ouly/scheduler/task_traits.hpp"
+#include <algorithm>
 #include <iterator>
+#include <latch>
+#include <optional>
 
 namespace ouly::detail
 {
@@ -64,6 +68,12 @@ concept HasParallelExecutionThreshold = requires {
   { T::parallel_execution_threshold } -> std::convertible_to<uint32_t>;
 };
 
+// Concept to check if a type has 'adaptive_splitting'
+template <typename T>
+concept HasAdaptiveSplitting = requires {
+  { T::adaptive_splitting } -> std::convertible_to<bool>;
+};
+
 template <typename T>
 struct fixed_batch_size_t
 {
@@ -100,6 +110,18 @@ struct parallel_execution_threshold_t<T>
   static constexpr uint32_t value = T::parallel_execution_threshold;
 };
 
+template <typename T>
+struct adaptive_splitting_t
+{
+  static constexpr bool value = default_task_traits::adaptive_splitting;
+};
+
+template <HasAdaptiveSplitting T>
+struct adaptive_splitting_t<T>
+{
+  static constexpr bool value = T::adaptive_splitting;
+};
+
 template <typename Traits>
 struct final_task_traits
 {
@@ -108,11 +130,122 @@ struct final_task_traits
   static constexpr uint32_t batches_per_worker = batches_per_worker_t<Traits>::value;
 
   static constexpr uint32_t parallel_execution_threshold = parallel_execution_threshold_t<Traits>::value;
+
+  static constexpr bool adaptive_splitting = adaptive_splitting_t<Traits>::value;
 };
 
+/**
+ * @brief Number of batches to split tk_count items into, batches_per_wk per worker and no more than there are items
+ */
 constexpr auto get_work_count(uint32_t batches_per_wk, uint32_t wk_count, uint32_t tk_count) -> uint32_t
 {
-  uint32_t batch_count = wk_count * batches_per_wk;
-  return (tk_count + batch_count - 1) / batch_count;
+  return std::min(wk_count * batches_per_wk, tk_count);
 }
-} // namespace ouly::detail
\ No newline at end of file
+
+/**
+ * @brief Split of a range into contiguous batches for the reduce and scan executers
+ */
+struct batch_layout
+{
+  uint32_t batch_count_ = 0;
+  uint32_t batch_size_  = 0;
+
+  [[nodiscard]] auto get_begin(uint32_t batch) const noexcept -> uint32_t
+  {
+    return batch * batch_size_;
+  }
+
+  [[nodiscard]] auto get_end(uint32_t batch, uint32_t count) const noexcept -> uint32_t
+  {
+    return std::min(get_begin(batch) + batch_size_, count);
+  }
+};
+
+template <typename Traits>
+constexpr auto get_batch_layout(uint32_t worker_count, uint32_t count) noexcept -> batch_layout
+{
+  if (count == 0)
+  {
+    return {};
+  }
+  uint32_t batch_size = Traits::fixed_batch_size;
+  if (batch_size == 0)
+  {
+    uint32_t batches = std::clamp(worker_count * std::max(1U, Traits::batches_per_worker), 1U, count);
+    batch_size       = (count + batches - 1) / batches;
+  }
+  return {(count + batch_size - 1) / batch_size, batch_size};
+}
+
+/**
+ * @brief Per batch partial result, padded to a cache line so concurrent batches never share a line
+ */
+template <typename T>
+struct alignas(ouly::cache_line_size) padded_slot
+{
+  std::optional<T> value_;
+};
+
+/**
+ * @brief Element accessor used by the executers, integral iterators are passed by value
+ */
+template <typename It>
+auto get_element(It it) -> decltype(auto)
+{
+  if constexpr (std::is_integral_v<It>)
+  {
+    return it;
+  }
+  else
+  {
+    return *it;
+  }
+}
+
+/**
+ * @brief Execute pending work on the calling worker until the latch is released, instead of blocking on it
+ */
+inline void help_until(worker_context const& this_context, std::latch& counter) noexcept
+{
+  auto& scheduler = this_context.get_scheduler();
+  while (!counter.try_wait())
+  {
+    if (!scheduler.busy_work(this_context.get_worker()))
+    {
+      ouly::cpu_pause();
+    }
+  }
+}
+
+/**
+ * @brief Run fn(batch, context) for every batch, the last batch is executed by the calling worker
+ */
+template <typename Fn>
+void run_batches(worker_context const& this_context, uint32_t batch_count, Fn& fn)
+{
+  struct batch_state
+  {
+    batch_state(Fn& f, uint32_t submitted) noexcept : fn_(&f), counter_(static_cast<ptrdiff_t>(submitted)) {}
+
+    Fn*        fn_;
+    std::latch counter_;
+  } state(fn, batch_count - 1);
+
+  auto group = this_context.get_workgroup();
+  this_context.get_scheduler().submit_batch(this_context.get_worker(), group, batch_count - 1,
+                                            [instance = &state, group](uint32_t batch)
+                                            {
+                                              return work_item::pbind(
+                                               [instance, batch](worker_context const& wc)
+                                               {
+                                                 (*instance->fn_)(batch, wc);
+                                                 instance->counter_.count_down();
+                                               },
+                                               group);
+                                            });
+
+  fn(batch_count - 1, this_context);
+  help_until(this_context, state.counter_);
+}
+
+} // namespace ouly::detail
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include "ouly/scheduler/detail/coro_frame_allocator.hpp"
 #include "ouly/scheduler/detail/get_awaiter.hpp"
 #include <array>
 #include <concepts>
@@ -27,6 +28,30 @@ public:
   {
     assert(0 && "Coroutine throwing! Terminate!");
   }
+
+  /**
+   * @brief Coroutine frames are allocated from per thread pools instead of the global heap
+   */
+  static auto operator new(std::size_t size) -> void*
+  {
+    return ouly::detail::allocate_coro_frame(size);
+  }
+
+  static void operator delete(void* frame, std::size_t size) noexcept
+  {
+    ouly::detail::deallocate_coro_frame(frame, size);
+  }
+
+protected:
+  /**
+   * @brief Complete a coroutine that has not started yet without running it, its awaiter resumes right away
+   */
+  void complete_cancelled() noexcept
+  {
+    // Pairs with the acquire in co_task::is_done, a thread that sees the task cancelled sees what preceded it
+    cancelled_.store(true, std::memory_order_release);
+    final_awaiter::complete(*this);
+  }
 };
 
 template <template <typename R> class TaskClass, typename Ty>
@@ -71,6 +96,16 @@ public:
     return TaskClass<Ty>(std::coroutine_handle<promise_type<TaskClass, Ty>>::from_promise(*this));
   }
 
+  /**
+   * @brief Complete without running, awaiters receive a value initialized result
+   */
+  void cancel() noexcept
+    requires(std::is_nothrow_default_constructible_v<Ty>)
+  {
+    ::new (data_) Ty();
+    complete_cancelled();
+  }
+
 private:
   alignas(alignof(Ty)) std::byte data_[sizeof(Ty)]{};
 };
@@ -121,6 +156,14 @@ public:
   void result() & noexcept {}
   void return_void() noexcept {}
 
+  /**
+   * @brief Complete without running
+   */
+  void cancel() noexcept
+  {
+    complete_cancelled();
+  }
+
   auto get_return_object() noexcept -> TaskClass<void>
   {
     return TaskClass<void>(std::coroutine_handle<promise_type<TaskClass, void>>::from_promise(*this));
@@ -136,6 +179,9 @@ public:
     return std::suspend_never();
   }
 
+  // A sequence is already running when it is submitted
+  void cancel() noexcept = delete;
+
   auto get_return_object() noexcept -> TaskClass<Ty>
   {
     return TaskClass<Ty>(std::coroutine_handle<sequence_promise<TaskClass, Ty>>::from_promise(*this));
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "ouly/scheduler/detail/worker.hpp"
+#include "ouly/utility/config.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace ouly
+{
+
+/**
+ * @brief Handle to a timer created with scheduler::submit_after or scheduler::submit_every
+ */
+struct timer_id
+{
+  static constexpr uint32_t invalid = std::numeric_limits<uint32_t>::max();
+
+  uint32_t index_      = invalid;
+  uint32_t generation_ = 0;
+
+  explicit operator bool() const noexcept
+  {
+    return index_ != invalid;
+  }
+};
+
+} // namespace ouly
+
+namespace ouly::detail
+{
+
+/**
+ * @brief Hierarchical timer wheel holding work items until their deadline.
+ *
+ * Time is measured in ticks. Level L has 64 slots of 64^L ticks each, a timer is linked into the lowest level whose
+ * span covers its deadline and moves down a level every time the wheel reaches the start of its slot, four levels cover
+ * 16M ticks and further deadlines wait in the last slot of the top level. Timer nodes are allocated in blocks and
+ * recycled through a free list, adding a timer does not allocate once the wheel has grown to its working size.
+ *
+ * The wheel is not thread safe, the scheduler guards it with a lock.
+ */
+class timer_wheel
+{
+public:
+  static constexpr uint32_t level_bits  = 6;
+  static constexpr uint32_t slot_count  = 1U << level_bits;
+  static constexpr uint32_t level_count = 4;
+  static constexpr uint32_t block_size  = 256;
+  static constexpr uint32_t nil         = std::numeric_limits<uint32_t>::max();
+  static constexpr uint64_t no_deadline = std::numeric_limits<uint64_t>::max();
+
+  timer_wheel() noexcept
+  {
+    for (auto& level : slots_)
+    {
+      level.fill(nil);
+    }
+  }
+
+  /**
+   * @brief Drop all timers and restart the wheel at the given tick
+   */
+  OULY_API void reset(uint64_t now) noexcept;
+
+  /**
+   * @brief Add a timer firing at deadline, and then every period ticks if period is not 0. Deadlines that already
+   * passed fire on the next tick.
+   */
+  OULY_API auto add(work_item const& work, uint64_t deadline, uint64_t period) -> timer_id;
+
+  /**
+   * @brief Remove a pending timer, returns false if it already fired or was cancelled
+   */
+  OULY_API auto cancel(timer_id id) noexcept -> bool;
+
+  /**
+   * @brief Earliest tick at which advance has something to do, a timer deadline or a slot moving down a level. Returns
+   * no_deadline if the wheel is empty.
+   */
+  [[nodiscard]] OULY_API auto next_deadline() const noexcept -> uint64_t;
+
+  [[nodiscard]] auto size() const noexcept -> uint32_t
+  {
+    return size_;
+  }
+
+  /**
+   * @brief Move the wheel to tick now, calling fire(work_item const&) for every timer that expired. Periodic timers are
+   * re-armed before they are fired. Returns the number of timers fired.
+   */
+  template <typename Fire>
+  auto advance(uint64_t now, Fire&& fire) -> uint32_t
+  {
+    uint32_t fired = 0;
+    while (true)
+    {
+      auto next = next_deadline();
+      if (next > now)
+      {
+        current_tick_ = std::max(current_tick_, now);
+        return fired;
+      }
+      current_tick_ = next;
+
+      // Move slots starting at this tick down, top level first so their timers can reach level 0 in the same pass
+      uint32_t top = 0;
+      while (top + 1 < level_count && (next & ((uint64_t{1} << ((top + 1) * level_bits)) - 1)) == 0)
+      {
+        ++top;
+      }
+      for (uint32_t level = top; level > 0; --level)
+      {
+        for (auto index = take_slot(level, get_slot(next, level)); index != nil;)
+        {
+          auto following = get_node(index).next_;
+          if (get_node(index).deadline_ <= next)
+          {
+            expire(index, now, fire);
+            ++fired;
+          }
+          else
+          {
+            link(index);
+          }
+          index = following;
+        }
+      }
+
+      for (auto index = take_slot(0, get_slot(next, 0)); index != nil;)
+      {
+        auto following = get_node(index).next_;
+        expire(index, now, fire);
+        ++fired;
+        index = following;
+      }
+    }
+  }
+
+private:
+  struct node
+  {
+    work_item work_;
+    uint64_t  deadline_   = 0;
+    uint64_t  period_     = 0;
+    uint32_t  next_       = nil;
+    uint32_t  prev_       = nil;
+    uint32_t  generation_ = 0;
+    // level * slot_count + slot while linked, nil otherwise
+    uint32_t slot_ = nil;
+  };
+
+  static constexpr auto get_slot(uint64_t tick, uint32_t level) noexcept -> uint32_t
+  {
+    return static_cast<uint32_t>(tick >> (level * level_bits)) & (slot_count - 1);
+  }
+
+  auto get_node(uint32_t index) noexcept -> node&
+  {
+    return blocks_[index / block_size][index % block_size];
+  }
+
+  template <typename Fire>
+  void expire(uint32_t index, uint64_t now, Fire& fire)
+  {
+    auto& n = get_node(index);
+    if (n.period_ != 0)
+    {
+      // Skip the periods that were missed by the time the wheel reaches now, the timer keeps its phase
+      n.deadline_ += ((now - n.deadline_) / n.period_ + 1) * n.period_;
+      link(index);
+      fire(static_cast<work_item const&>(n.work_));
+    }
+    else
+    {
+      work_item work = n.work_;
+      release(index);
+      fire(static_cast<work_item const&>(work));
+    }
+  }
+
+  OULY_API void link(uint32_t index) noexcept;
+  OULY_API void unlink(uint32_t index) noexcept;
+  OULY_API void release(uint32_t index) noexcept;
+  OULY_API auto take_slot(uint32_t level, uint32_t slot) noexcept -> uint32_t;
+
+  std::vector<std::unique_ptr<node[]>>                      blocks_;
+  std::array<std::array<uint32_t, slot_count>, level_count> slots_{};
+  std::array<uint64_t, level_count>                         occupied_{};
+  uint64_t                                                  current_tick_ = 0;
+  uint32_t                                                  free_         = nil;
+  uint32_t                                                  size_         = 0;
+};
+
+} // namespace ouly::detail
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "ouly/scheduler/detail/atomic_slot.hpp"
+#include "ouly/utility/config.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace ouly::detail
+{
+
+/**
+ * @brief Bounded lock-free Chase-Lev work stealing deque.
+ *
+ * The owning worker pushes and pops items at the bottom (LIFO), while any other worker can steal items from the top
+ * (FIFO). Only the owner may call try_push and try_pop, try_steal is safe to call from any thread.
+ *
+ * The deque does not grow, try_push fails when the deque is full and the caller is expected to spill the item to a
+ * shared queue. Not growing means no buffer ever has to be reclaimed while a thief might still be reading from it.
+ *
+ * Based on "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013.
+ *
+ * @tparam T Item type, must be cheap to copy and trivially destructible as items are read speculatively by thieves and
+ * discarded if the steal fails. Items are kept in atomic_slot storage so those reads never race the owner's writes.
+ */
+template <typename T>
+class work_stealing_deque
+{
+  static_assert(std::is_nothrow_copy_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                "Work stealing deque items must be nothrow copyable and trivially destructible");
+
+public:
+  using index_type = std::int64_t;
+
+  work_stealing_deque() noexcept                                     = default;
+  work_stealing_deque(work_stealing_deque const&)                    = delete;
+  work_stealing_deque(work_stealing_deque&&)                         = delete;
+  auto operator=(work_stealing_deque const&) -> work_stealing_deque& = delete;
+  auto operator=(work_stealing_deque&&) -> work_stealing_deque&      = delete;
+  ~work_stealing_deque() noexcept                                    = default;
+
+  /**
+   * @brief Allocate storage for the deque, capacity is rounded up to a power of 2. Must only be called when no other
+   * thread is accessing the deque.
+   */
+  void reset(std::uint32_t capacity)
+  {
+    std::uint32_t size = 1;
+    while (size < capacity)
+    {
+      size <<= 1U;
+    }
+    items_ = std::make_unique<atomic_slot<T>[]>(size);
+    mask_  = static_cast<index_type>(size) - 1;
+    top_.store(0, std::memory_order_relaxed);
+    bottom_.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Push an item at the bottom, owner only.
+   * @return false if the deque is full
+   */
+  auto try_push(T const& item) noexcept -> bool
+  {
+    index_type b = bottom_.load(std::memory_order_relaxed);
+    index_type t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_)
+    {
+      return false;
+    }
+    items_[static_cast<std::size_t>(b & mask_)].store(item);
+    bottom_.store(b + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Pop the most recently pushed item from the bottom, owner only.
+   * @return false if the deque was empty, or the last item was stolen
+   */
+  auto try_pop(T& out) noexcept -> bool
+  {
+    index_type b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    index_type t = top_.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    out = items_[static_cast<std::size_t>(b & mask_)].load();
+    if (t == b)
+    {
+      // Last item, race against thieves
+      bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Steal the oldest item from the top, can be called from any thread.
+   * @return false if the deque was empty, or another thread won the race for the item
+   */
+  auto try_steal(T& out) noexcept -> bool
+  {
+    index_type t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    index_type b = bottom_.load(std::memory_order_acquire);
+
+    if (t >= b)
+    {
+      return false;
+    }
+
+    // The owner may be overwriting the slot if the deque wrapped, the exchange fails then and the copy is dropped
+    T item = items_[static_cast<std::size_t>(t & mask_)].load();
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+      return false;
+    }
+    out = item;
+    return true;
+  }
+
+  /**
+   * @brief Approximate emptiness check, exact only when the deque is not being modified.
+   */
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return bottom_.load(std::memory_order_acquire) <= top_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Approximate item count, exact only when the deque is not being modified.
+   */
+  [[nodiscard]] auto size() const noexcept -> std::uint32_t
+  {
+    auto diff = bottom_.load(std::memory_order_acquire) - top_.load(std::memory_order_acquire);
+    return diff > 0 ? static_cast<std::uint32_t>(diff) : 0;
+  }
+
+private:
+  alignas(ouly::cache_line_size) std::atomic<index_type> top_{0};
+  alignas(ouly::cache_line_size) std::atomic<index_type> bottom_{0};
+  std::unique_ptr<atomic_slot<T>[]> items_;
+  index_type                        mask_ = -1;
+};
+
+} // namespace ouly::detail
@@ -4,10 +4,19 @@
 
 #include "ouly/allocators/default_allocator.hpp"
 #include "ouly/containers/basic_queue.hpp"
+#include "ouly/scheduler/detail/atomic_slot.hpp"
+#include "ouly/scheduler/detail/mpsc_mailbox.hpp"
+#include "ouly/scheduler/detail/work_stealing_deque.hpp"
+#include "ouly/scheduler/scheduler_options.hpp"
 #include "ouly/scheduler/spin_lock.hpp"
 #include "ouly/scheduler/task.hpp"
+#include "ouly/scheduler/trace.hpp"
 #include "ouly/scheduler/worker_context.hpp"
 #include "ouly/utility/tagged_ptr.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <limits>
 #include <mutex>
@@ -18,7 +27,7 @@ namespace ouly::detail
 {
 
 static constexpr uint32_t max_worker_groups   = 32;
-static constexpr uint32_t max_local_work_item = 32; // 2 cache lines
+static constexpr uint32_t max_local_work_item = 32; // power of 2, ring index wraps around
 
 using work_item = task_delegate;
 
@@ -28,21 +37,117 @@ struct work_queue_traits
   using allocator_t                     = ouly::default_allocator<>;
 };
 
-using work_queue       = ouly::basic_queue<work_item, work_queue_traits>;
-using async_work_queue = std::pair<ouly::spin_lock, work_queue>;
+using work_queue   = ouly::basic_queue<work_item, work_queue_traits>;
+using work_deque   = ouly::detail::work_stealing_deque<work_item>;
+using work_mailbox = ouly::detail::mpsc_mailbox<work_item>;
+using mailbox_pool = ouly::detail::mailbox_node_pool<work_item>;
+
+/**
+ * @brief Shared queue of a worker in a group, one FIFO lane per task_priority behind a single lock
+ */
+struct lane_queue
+{
+  [[nodiscard]] auto get_lane(task_priority priority) noexcept -> work_queue&
+  {
+    return lanes_[static_cast<uint32_t>(priority)];
+  }
+
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return std::ranges::all_of(lanes_,
+                               [](work_queue const& lane)
+                               {
+                                 return lane.empty();
+                               });
+  }
+
+  ouly::spin_lock                             lock_;
+  std::array<work_queue, task_priority_count> lanes_;
+  // Items in all lanes, written under lock_ and read without it to skip empty queues
+  std::atomic_uint32_t size_ = 0;
+};
+
+/**
+ * @brief Items waiting in the shared queues of a group, read without a lock before a worker takes any queue lock
+ */
+struct alignas(ouly::cache_line_size) shared_counters
+{
+  // All items, a worker does not walk the queues while there are none
+  std::atomic_uint32_t items_ = 0;
+  // High priority items, checked before a worker looks at its own queue
+  std::atomic_uint32_t urgent_ = 0;
+  // First queue tried by the next push, any thread can push so it is only ever advanced with fetch_add
+  std::atomic_uint32_t push_offset_ = 0;
+};
+
+/**
+ * @brief Bounded per worker ring, only the owning worker pushes at the tail, the owner and thieves pop from the head.
+ */
+struct local_queue
+{
+  auto try_push(work_item const& item) noexcept -> bool
+  {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= max_local_work_item)
+    {
+      return false;
+    }
+    queue_[tail % max_local_work_item].store(item);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto try_pop(work_item& out) noexcept -> bool
+  {
+    auto head = head_.load(std::memory_order_acquire);
+    while (head != tail_.load(std::memory_order_acquire))
+    {
+      // Slot can only be overwritten once head moves past it, in which case the exchange fails and the copy is dropped
+      work_item item = queue_[head % max_local_work_item].load();
+      if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+        out = item;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] auto size() const noexcept -> uint32_t
+  {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  alignas(ouly::cache_line_size) std::atomic_uint32_t     head_ = 0;
+  alignas(ouly::cache_line_size) std::atomic_uint32_t     tail_ = 0;
+  std::array<atomic_slot<work_item>, max_local_work_item> queue_;
+};
 
 struct workgroup
 {
-  // Global queues, one per thread group
-  std::unique_ptr<ouly::detail::async_work_queue[]> work_queues_;
-  uint32_t                                          thread_count_     = 0;
-  uint32_t                                          start_thread_idx_ = 0;
-  uint32_t                                          push_offset_      = 0;
-  uint32_t                                          priority_         = 0;
+  // Shared queues, one per worker in the group
+  std::unique_ptr<ouly::detail::lane_queue[]> work_queues_;
+  // Items waiting in work_queues_
+  std::unique_ptr<ouly::detail::shared_counters> shared_;
+  // Per worker deques, only allocated in work_queue_mode::work_stealing
+  std::unique_ptr<ouly::detail::work_deque[]> work_deques_;
+  // Per worker local rings, only allocated in work_queue_mode::shared_queues
+  std::unique_ptr<ouly::detail::local_queue[]> local_queues_;
+  // Victim offsets per worker, closest cache first, only built for groups placed on a cpu topology
+  std::unique_ptr<uint32_t[]> steal_order_;
+  uint32_t                                     thread_count_     = 0;
+  uint32_t                                     start_thread_idx_ = 0;
+  uint32_t                                     priority_         = 0;
 
   auto create_group(uint32_t start, uint32_t count, uint32_t priority) noexcept -> uint32_t
   {
-    work_queues_      = std::make_unique<ouly::detail::async_work_queue[]>(count);
+    work_queues_      = std::make_unique<ouly::detail::lane_queue[]>(count);
+    shared_           = std::make_unique<ouly::detail::shared_counters>();
     thread_count_     = count;
     start_thread_idx_ = start;
     this->priority_   = priority;
@@ -66,14 +171,16 @@ struct wake_event
     semaphore_.release();
   }
 
-  std::binary_semaphore semaphore_;
-};
+  /**
+   * @brief Wait for a notification until the deadline, returns false on timeout
+   */
+  template <typename Clock, typename Duration>
+  auto wait_until(std::chrono::time_point<Clock, Duration> const& deadline) noexcept -> bool
+  {
+    return semaphore_.try_acquire_until(deadline);
+  }
 
-struct local_queue
-{
-  std::atomic_uint32_t                       head_;
-  std::atomic_uint32_t                       tail_;
-  std::array<work_item, max_local_work_item> queue_;
+  std::binary_semaphore semaphore_;
 };
 
 struct group_range
@@ -88,16 +195,54 @@ struct group_range
   }
 };
 
+/**
+ * @brief Worker statistics, only written by the owning worker and read by any thread. Kept on their own cache lines so
+ * increments never contend with the worker's shared state.
+ */
+struct alignas(ouly::cache_line_size) worker_counters
+{
+  static void increment(std::atomic_uint64_t& counter, uint64_t by = 1) noexcept
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic_uint64_t, max_worker_groups> tasks_executed_{};
+
+  std::atomic_uint64_t local_pops_      = 0;
+  std::atomic_uint64_t shared_pops_     = 0;
+  std::atomic_uint64_t stolen_pops_     = 0;
+  std::atomic_uint64_t exclusive_pops_  = 0;
+  std::atomic_uint64_t local_work_hits_ = 0;
+  std::atomic_uint64_t failed_locks_    = 0;
+  std::atomic_uint64_t parked_ns_       = 0;
+
+  std::atomic_uint64_t spin_polls_  = 0;
+  std::atomic_uint64_t yield_polls_ = 0;
+  std::atomic_uint64_t spin_hits_   = 0;
+  std::atomic_uint64_t yield_hits_  = 0;
+  std::atomic_uint64_t parks_       = 0;
+};
+
 struct worker
 {
   // Context per work group
   std::unique_ptr<worker_context[]> contexts_;
-  // Worker specific item
-  async_work_queue exlusive_items_;
+  // Worker specific items, pushed by any worker and popped by this one
+  work_mailbox exlusive_items_;
+  // Nodes for the items this worker submits to other workers' mailboxes
+  mailbox_pool mailbox_nodes_;
   // worker id
   worker_id id_;
   // quit event
   std::atomic_bool quitting_ = false;
+  // statistics
+  worker_counters stats_;
+  // Looks for work since begin_execution, drives priority aging
+  uint32_t lookups_ = 0;
+#ifdef OULY_SCHEDULER_TRACE
+  // event trace, written by the worker only
+  trace_ring trace_;
+#endif
 };
 
 } // namespace ouly::detail
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "ouly/scheduler/scheduler.hpp"
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace ouly
+{
+
+/**
+ * @brief How an io_service performs file reads and writes
+ */
+enum class io_backend : uint8_t
+{
+  /**
+   * io_uring when the kernel supports it, thread_pool otherwise
+   */
+  automatic,
+  /**
+   * Linux io_uring (5.6+), a single completion thread resumes the awaiting coroutines
+   */
+  io_uring,
+  /**
+   * A few threads running blocking positional reads and writes
+   */
+  thread_pool,
+};
+
+struct io_service_options
+{
+  static constexpr uint32_t default_queue_depth      = 256;
+  static constexpr uint32_t default_fallback_threads = 2;
+
+  io_backend backend = io_backend::automatic;
+  /**
+   * Submission queue size of the io_uring
+   */
+  uint32_t queue_depth = default_queue_depth;
+  /**
+   * Number of threads of the thread_pool backend
+   */
+  uint32_t fallback_threads = default_fallback_threads;
+};
+
+/**
+ * @brief Outcome of an asynchronous read or write
+ */
+struct io_result
+{
+  // Bytes transferred, can be less than requested at the end of a file
+  std::size_t bytes_ = 0;
+  // errno value of a failed request, 0 on success
+  int error_ = 0;
+
+  explicit operator bool() const noexcept
+  {
+    return error_ == 0;
+  }
+};
+
+namespace detail
+{
+enum class io_op : uint8_t
+{
+  read,
+  write,
+};
+
+/**
+ * @brief A read or write in flight, lives in the awaiting coroutine's frame until it is resumed
+ */
+struct io_request
+{
+  std::byte*   data_   = nullptr;
+  std::size_t  size_   = 0;
+  uint64_t     offset_ = 0;
+  int          fd_     = -1;
+  io_op        op_     = io_op::read;
+  workgroup_id group_  = default_workgroup_id;
+  void*        coroutine_ = nullptr;
+  int64_t      result_    = 0;
+};
+
+class io_backend_impl;
+} // namespace detail
+
+/**
+ * @brief Asynchronous file io for coroutines running on a scheduler.
+ *
+ * Requests go through io_uring on Linux, or through a small pool of blocking threads when io_uring is not available.
+ * Completed requests resume the awaiting coroutine on the workgroup given with the request, so no worker blocks on io.
+ * The service must be created after begin_execution and destroyed before end_execution, the destructor waits for
+ * pending requests.
+ *
+ * @code
+ * ouly::io_service io(scheduler);
+ * auto load = [&](int fd) -> ouly::co_task<void>
+ * {
+ *   std::array<std::byte, 4096> block;
+ *   auto result = co_await ouly::async_read(fd, block, 0, stream_group);
+ *   // runs on a worker of stream_group
+ * };
+ * @endcode
+ */
+class io_service
+{
+public:
+  OULY_API explicit io_service(scheduler& owner, io_service_options const& options = {});
+  io_service(io_service const&)                    = delete;
+  io_service(io_service&&)                         = delete;
+  auto operator=(io_service const&) -> io_service& = delete;
+  auto operator=(io_service&&) -> io_service&      = delete;
+  OULY_API ~io_service() noexcept;
+
+  /**
+   * @brief Backend selected at construction, never io_backend::automatic
+   */
+  [[nodiscard]] auto get_backend() const noexcept -> io_backend
+  {
+    return backend_;
+  }
+
+  [[nodiscard]] auto get_scheduler() const noexcept -> scheduler&
+  {
+    return *scheduler_;
+  }
+
+  /**
+   * @brief Service used by the async_read and async_write overloads without an io_service, the first service created
+   * becomes the default one
+   */
+  [[nodiscard]] OULY_API static auto get_default() noexcept -> io_service&;
+  OULY_API void make_default() noexcept;
+
+  /**
+   * @brief Start a request, its coroutine is resumed through the scheduler once it completes
+   */
+  OULY_API void submit(ouly::detail::io_request& request) noexcept;
+
+  /**
+   * @brief Resume the coroutine of a completed request, called by the backends
+   */
+  void complete(ouly::detail::io_request& request, int64_t result) noexcept;
+
+private:
+  scheduler*                                     scheduler_ = nullptr;
+  std::unique_ptr<ouly::detail::io_backend_impl> impl_;
+  std::atomic_uint32_t                           in_flight_ = 0;
+  io_backend                                     backend_   = io_backend::thread_pool;
+};
+
+/**
+ * @brief Awaiter of async_read and async_write
+ */
+class io_awaiter
+{
+public:
+  io_awaiter(io_service& service, ouly::detail::io_request const& request) noexcept
+      : service_(&service), request_(request)
+  {}
+
+  [[nodiscard]] static auto await_ready() noexcept -> bool
+  {
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<> awaiting_coro) noexcept
+  {
+    request_.coroutine_ = awaiting_coro.address();
+    service_->submit(request_);
+  }
+
+  [[nodiscard]] auto await_resume() const noexcept -> io_result
+  {
+    if (request_.result_ < 0)
+    {
+      return {.bytes_ = 0, .error_ = static_cast<int>(-request_.result_)};
+    }
+    return {.bytes_ = static_cast<std::size_t>(request_.result_), .error_ = 0};
+  }
+
+private:
+  io_service*              service_ = nullptr;
+  ouly::detail::io_request request_;
+};
+
+/**
+ * @brief Read from a file at an offset, the awaiting coroutine is resumed on a worker of the group
+ */
+inline auto async_read(io_service& service, int fd, std::span<std::byte> buffer, uint64_t offset,
+                       workgroup_id group = default_workgroup_id) noexcept -> io_awaiter
+{
+  return {service, ouly::detail::io_request{.data_   = buffer.data(),
+                                            .size_   = buffer.size(),
+                                            .offset_ = offset,
+                                            .fd_     = fd,
+                                            .op_     = ouly::detail::io_op::read,
+                                            .group_  = group}};
+}
+
+/**
+ * @brief Write to a file at an offset, the awaiting coroutine is resumed on a worker of the group
+ */
+inline auto async_write(io_service& service, int fd, std::span<std::byte const> buffer, uint64_t offset,
+                        workgroup_id group = default_workgroup_id) noexcept -> io_awaiter
+{
+  // The buffer is only read from
+  return {service, ouly::detail::io_request{.data_   = const_cast<std::byte*>(buffer.data()), // NOLINT
+                                            .size_   = buffer.size(),
+                                            .offset_ = offset,
+                                            .fd_     = fd,
+                                            .op_     = ouly::detail::io_op::write,
+                                            .group_  = group}};
+}
+
+/**
+ * @brief Read through the default io_service
+ * @see io_service::get_default
+ */
+inline auto async_read(int fd, std::span<std::byte> buffer, uint64_t offset,
+                       workgroup_id group = default_workgroup_id) noexcept -> io_awaiter
+{
+  return async_read(io_service::get_default(), fd, buffer, offset, group);
+}
+
+/**
+ * @brief Write through the default io_service
+ * @see io_service::get_default
+ */
+inline auto async_write(int fd, std::span<std::byte const> buffer, uint64_t offset,
+                        workgroup_id group = default_workgroup_id) noexcept -> io_awaiter
+{
+  return async_write(io_service::get_default(), fd, buffer, offset, group);
+}
+
+} // namespace ouly
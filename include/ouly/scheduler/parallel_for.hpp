@@ -4,6 +4,7 @@
 #include "ouly/scheduler/detail/parallel_executer.hpp"
 #include "ouly/utility/integer_range.hpp"
 #include "ouly/utility/type_traits.hpp"
+#include <atomic>
 #include <functional>
 #include <latch>
 #include <type_traits>
@@ -47,7 +48,8 @@ namespace ouly
  * The implementation automatically:
  * - Determines optimal batch sizes based on task traits
  * - Handles task distribution across available workers
- * - Manages synchronization using std::latch
+ * - Manages synchronization using std::latch, the calling worker executes pending work while waiting
+ * - Optionally splits the range lazily as workers become idle, see default_task_traits::adaptive_splitting
  * - Falls back to sequential execution for small ranges
  *
  * @note The parallel execution is only triggered if the task count exceeds
@@ -80,32 +82,37 @@ void launch_parallel_tasks(L& lambda, auto range, uint32_t work_count, uint32_t
   using size_type                                    = uint32_t;
   constexpr bool                   is_range_executor = ouly::detail::RangeExcuter<L, iterator_t>;
   parallel_for_data<iterator_t, L> pfor_instance(lambda, std::begin(range), work_count - 1);
-  size_type                        begin = 0;
-  for (size_type i = 1; i < work_count; ++i)
-  {
-    auto next = std::min(begin + fixed_batch_size, count);
-    scheduler.submit(this_context.get_worker(), this_context.get_workgroup(),
-                     [instance = &pfor_instance, start = begin, end = next](worker_context const& wc)
-                     {
-                       if constexpr (ouly::detail::RangeExcuter<L, iterator_t>)
-                       {
-                         instance->lambda_instance_.get()(instance->first_ + start, instance->first_ + end, wc);
-                       }
-                       else
-                       {
-                         if constexpr (std::is_integral_v<std::decay_t<decltype(instance->first_)>>)
-                         {
-                           instance->lambda_instance_.get()((instance->first_ + start), wc);
-                         }
-                         else
-                         {
-                           instance->lambda_instance_.get()(*(instance->first_ + start), wc);
-                         }
-                       }
-                       instance->counter_.count_down();
-                     });
-    begin = next;
-  }
+
+  scheduler.submit_batch(
+   this_context.get_worker(), this_context.get_workgroup(), work_count - 1,
+   [instance = &pfor_instance, fixed_batch_size, count, group = this_context.get_workgroup()](size_type i)
+   {
+     size_type start = i * fixed_batch_size;
+     size_type end   = std::min(start + fixed_batch_size, count);
+     return ouly::detail::work_item::pbind(
+      [instance, start, end](worker_context const& wc)
+      {
+        if constexpr (ouly::detail::RangeExcuter<L, iterator_t>)
+        {
+          instance->lambda_instance_.get()(instance->first_ + start, instance->first_ + end, wc);
+        }
+        else
+        {
+          if constexpr (std::is_integral_v<std::decay_t<decltype(instance->first_)>>)
+          {
+            instance->lambda_instance_.get()((instance->first_ + start), wc);
+          }
+          else
+          {
+            instance->lambda_instance_.get()(*(instance->first_ + start), wc);
+          }
+        }
+        instance->counter_.count_down();
+      },
+      group);
+   });
+
+  size_type begin = (work_count - 1) * fixed_batch_size;
 
   // Work before wait
   {
@@ -130,7 +137,82 @@ void launch_parallel_tasks(L& lambda, auto range, uint32_t work_count, uint32_t
     }
   }
 
-  pfor_instance.counter_.wait();
+  ouly::detail::help_until(this_context, pfor_instance.counter_);
+}
+
+template <typename Iterator, typename L>
+struct adaptive_for_data
+{
+  adaptive_for_data(L& lambda, Iterator f, uint32_t grain) noexcept : first_(f), lambda_instance_(lambda), grain_(grain)
+  {}
+
+  Iterator                  first_;
+  std::reference_wrapper<L> lambda_instance_;
+  uint32_t                  grain_;
+  // Split off tasks not finished yet
+  std::atomic_uint32_t pending_ = 0;
+};
+
+/**
+ * @brief Lazy binary splitting, work through [start, end) one grain at a time, and split off the upper half of the
+ * remaining range whenever the previously split off half has been taken from this worker's queue.
+ */
+template <typename Iterator, typename L>
+void run_adaptive_range(adaptive_for_data<Iterator, L>& instance, uint32_t start, uint32_t end,
+                        worker_context const& wc) noexcept
+{
+  auto& scheduler = wc.get_scheduler();
+  auto  group     = wc.get_workgroup();
+  while (start < end)
+  {
+    if (end - start > instance.grain_ && !scheduler.has_local_work(wc.get_worker(), group))
+    {
+      uint32_t mid = start + ((end - start) / 2);
+      instance.pending_.fetch_add(1, std::memory_order_relaxed);
+      scheduler.submit(wc.get_worker(), group,
+                       ouly::detail::work_item::pbind(
+                        [instance = &instance, mid, end](worker_context const& split_wc)
+                        {
+                          run_adaptive_range(*instance, mid, end, split_wc);
+                          instance->pending_.fetch_sub(1, std::memory_order_release);
+                        },
+                        group));
+      end = mid;
+      continue;
+    }
+
+    uint32_t next = std::min(start + instance.grain_, end);
+    if constexpr (ouly::detail::RangeExcuter<L, Iterator>)
+    {
+      instance.lambda_instance_.get()(instance.first_ + start, instance.first_ + next, wc);
+    }
+    else
+    {
+      for (auto it = instance.first_ + start, last = instance.first_ + next; it != last; ++it)
+      {
+        instance.lambda_instance_.get()(ouly::detail::get_element(it), wc);
+      }
+    }
+    start = next;
+  }
+}
+
+template <typename L>
+void launch_adaptive_tasks(L& lambda, auto range, uint32_t grain, uint32_t count, worker_context const& this_context)
+{
+  using iterator_t = decltype(std::begin(range));
+
+  adaptive_for_data<iterator_t, L> instance(lambda, std::begin(range), grain);
+  run_adaptive_range(instance, 0, count, this_context);
+
+  auto& scheduler = this_context.get_scheduler();
+  while (instance.pending_.load(std::memory_order_acquire) != 0)
+  {
+    if (!scheduler.busy_work(this_context.get_worker()))
+    {
+      ouly::cpu_pause();
+    }
+  }
 }
 
 template <typename L, typename FwIt, typename TaskTr = default_task_traits>
@@ -144,22 +226,6 @@ void parallel_for(L lambda, FwIt range, worker_context const& this_context, Task
 
   size_type count = it_helper::size(range);
 
-  constexpr uint32_t min_batches_per_worker = 1;
-  const size_type    work_count             = [&]()
-  {
-    if (!is_range_executor)
-    {
-      return count;
-    }
-    if (traits::fixed_batch_size)
-    {
-      return (count + traits::fixed_batch_size - 1) / traits::fixed_batch_size;
-    }
-    return ouly::detail::get_work_count(std::max(min_batches_per_worker, traits::batches_per_worker),
-                                        this_context.get_scheduler().get_worker_count(this_context.get_workgroup()),
-                                        count);
-  }();
-
   const size_type fixed_batch_size = [&]()
   {
     if (!is_range_executor)
@@ -170,9 +236,14 @@ void parallel_for(L lambda, FwIt range, worker_context const& this_context, Task
     {
       return traits::fixed_batch_size;
     }
-    return (count + work_count - 1) / work_count;
+    auto workers = this_context.get_scheduler().get_worker_count(this_context.get_workgroup());
+    auto batches = ouly::detail::get_work_count(std::max(1U, traits::batches_per_worker), workers, count);
+    return std::max<size_type>((count + batches - 1) / std::max<size_type>(batches, 1), 1);
   }();
 
+  // Batch count follows the rounded up batch size so no batch starts past the end
+  const size_type work_count = (count + fixed_batch_size - 1) / fixed_batch_size;
+
   if (count <= traits::parallel_execution_threshold || work_count <= 1)
   {
     if constexpr (is_range_executor)
@@ -194,6 +265,13 @@ void parallel_for(L lambda, FwIt range, worker_context const& this_context, Task
       }
     }
   }
+  else if constexpr (traits::adaptive_splitting)
+  {
+    // Split no finer than the static batches would
+    auto layout = ouly::detail::get_batch_layout<traits>(
+     this_context.get_scheduler().get_worker_count(this_context.get_workgroup()), count);
+    launch_adaptive_tasks(lambda, range, layout.batch_size_, count, this_context);
+  }
   else
   {
     launch_parallel_tasks(lambda, range, work_count, fixed_batch_size, count, this_context);
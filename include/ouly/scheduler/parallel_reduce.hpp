@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ouly/scheduler/detail/parallel_executer.hpp"
+#include <functional>
+#include <vector>
+
+namespace ouly
+{
+
+/**
+ * @brief Transform every element of a range and reduce the results in parallel
+ *
+ * The range is split into batches following the task traits, every batch folds its elements into a private cache line
+ * padded slot, and the calling worker combines the slots in batch order once all batches are done. No atomics are
+ * shared between batches.
+ *
+ * @param range Range of elements, or an integer_range in which case the transform receives the integers
+ * @param init Initial value, combined first with the batch results
+ * @param reduce Associative binary operation combining two transformed values
+ * @param transform Unary operation applied to every element
+ *
+ * @code
+ *   auto length_sq = ouly::parallel_transform_reduce(
+ *     std::span(points), 0.0f, std::plus<>(), [](vec3 const& p) { return dot(p, p); }, ouly::default_workgroup_id);
+ * @endcode
+ *
+ * @note The reduction is evaluated in batch order but the grouping differs from a sequential fold, reduce must be
+ * associative.
+ */
+template <typename T, typename FwIt, typename BinaryOp, typename UnaryOp, typename TaskTr = default_task_traits>
+auto parallel_transform_reduce(FwIt const& range, T init, BinaryOp reduce, UnaryOp transform,
+                               worker_context const& this_context, TaskTr /*unused*/ = {}) -> T
+{
+  using traits    = ouly::detail::final_task_traits<TaskTr>;
+  using it_helper = ouly::detail::it_size_type<FwIt>;
+  using size_type = uint32_t;
+
+  size_type count  = it_helper::size(range);
+  auto      layout = ouly::detail::get_batch_layout<traits>(
+   this_context.get_scheduler().get_worker_count(this_context.get_workgroup()), count);
+
+  auto fold = [&](T acc, size_type begin, size_type end) -> T
+  {
+    for (auto it = std::begin(range) + begin, last = std::begin(range) + end; it != last; ++it)
+    {
+      acc = reduce(std::move(acc), transform(ouly::detail::get_element(it)));
+    }
+    return acc;
+  };
+
+  if (count <= traits::parallel_execution_threshold || layout.batch_count_ <= 1)
+  {
+    return fold(std::move(init), 0, count);
+  }
+
+  std::vector<ouly::detail::padded_slot<T>> slots(layout.batch_count_);
+
+  auto batch_fn = [&](uint32_t batch, worker_context const& /*unused*/)
+  {
+    auto begin = layout.get_begin(batch);
+    auto end   = layout.get_end(batch, count);
+    // Batches are never empty, seed the fold with the first element instead of requiring an identity value
+    auto first = std::begin(range) + begin;
+    slots[batch].value_.emplace(fold(T(transform(ouly::detail::get_element(first))), begin + 1, end));
+  };
+  ouly::detail::run_batches(this_context, layout.batch_count_, batch_fn);
+
+  for (auto& slot : slots)
+  {
+    init = reduce(std::move(init), std::move(*slot.value_));
+  }
+  return init;
+}
+
+/**
+ * @brief Transform and reduce a range in parallel on the calling worker's context for the given workgroup
+ */
+template <typename T, typename FwIt, typename BinaryOp, typename UnaryOp, typename TaskTr = default_task_traits>
+auto parallel_transform_reduce(FwIt const& range, T init, BinaryOp reduce, UnaryOp transform, workgroup_id workgroup,
+                               TaskTr tt = {}) -> T
+{
+  return parallel_transform_reduce(range, std::move(init), std::move(reduce), std::move(transform),
+                                   worker_context::get(workgroup), tt);
+}
+
+/**
+ * @brief Reduce the elements of a range in parallel
+ *
+ * @code
+ *   int64_t sum = ouly::parallel_reduce(std::span(values), int64_t{0}, std::plus<>(), ouly::default_workgroup_id);
+ * @endcode
+ *
+ * @see parallel_transform_reduce
+ */
+template <typename T, typename FwIt, typename BinaryOp, typename TaskTr = default_task_traits>
+auto parallel_reduce(FwIt const& range, T init, BinaryOp reduce, worker_context const& this_context, TaskTr tt = {})
+ -> T
+{
+  return parallel_transform_reduce(range, std::move(init), std::move(reduce), std::identity(), this_context, tt);
+}
+
+/**
+ * @brief Reduce the elements of a range in parallel on the calling worker's context for the given workgroup
+ */
+template <typename T, typename FwIt, typename BinaryOp, typename TaskTr = default_task_traits>
+auto parallel_reduce(FwIt const& range, T init, BinaryOp reduce, workgroup_id workgroup, TaskTr tt = {}) -> T
+{
+  return parallel_transform_reduce(range, std::move(init), std::move(reduce), std::identity(),
+                                   worker_context::get(workgroup), tt);
+}
+
+} // namespace ouly
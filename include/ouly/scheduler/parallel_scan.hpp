@@ -0,0 +1,146 @@
+#pragma once
+
+#include "ouly/scheduler/detail/parallel_executer.hpp"
+#include <vector>
+
+namespace ouly::detail
+{
+
+/**
+ * @brief Two pass blocked scan.
+ *
+ * The first pass reduces every batch but the last into its padded slot, the calling worker then turns the slots into
+ * per batch carries with a short sequential scan, and the second pass scans every batch seeded with its carry. Scanning
+ * in place, with out pointing at the input, is supported.
+ */
+template <bool Inclusive, typename T, typename FwIt, typename OutIt, typename BinaryOp, typename TaskTr>
+void parallel_scan(FwIt const& range, OutIt out, std::optional<T> init, BinaryOp op,
+                   worker_context const& this_context)
+{
+  using traits    = ouly::detail::final_task_traits<TaskTr>;
+  using it_helper = ouly::detail::it_size_type<FwIt>;
+  using size_type = uint32_t;
+
+  size_type count  = it_helper::size(range);
+  auto      layout = ouly::detail::get_batch_layout<traits>(
+   this_context.get_scheduler().get_worker_count(this_context.get_workgroup()), count);
+
+  auto scan = [&](std::optional<T> carry, size_type begin, size_type end)
+  {
+    auto dst = out + begin;
+    for (auto it = std::begin(range) + begin, last = std::begin(range) + end; it != last; ++it, ++dst)
+    {
+      T value = ouly::detail::get_element(it);
+      if constexpr (Inclusive)
+      {
+        carry.emplace(carry ? op(std::move(*carry), std::move(value)) : std::move(value));
+        *dst = *carry;
+      }
+      else
+      {
+        T next = op(*carry, std::move(value));
+        *dst   = std::move(*carry);
+        carry.emplace(std::move(next));
+      }
+    }
+  };
+
+  if (count <= traits::parallel_execution_threshold || layout.batch_count_ <= 1)
+  {
+    scan(std::move(init), 0, count);
+    return;
+  }
+
+  std::vector<ouly::detail::padded_slot<T>> slots(layout.batch_count_);
+
+  auto reduce_batch = [&](uint32_t batch, worker_context const& /*unused*/)
+  {
+    auto begin = layout.get_begin(batch);
+    auto end   = layout.get_end(batch, count);
+    auto it    = std::begin(range) + begin;
+    T    acc   = ouly::detail::get_element(it);
+    for (++it; it != std::begin(range) + end; ++it)
+    {
+      acc = op(std::move(acc), ouly::detail::get_element(it));
+    }
+    slots[batch].value_.emplace(std::move(acc));
+  };
+  // The last batch's total is never needed
+  ouly::detail::run_batches(this_context, layout.batch_count_ - 1, reduce_batch);
+
+  // Exclusive scan of the batch totals gives every batch its carry
+  std::optional<T> carry = std::move(init);
+  for (auto& slot : slots)
+  {
+    std::optional<T> total = std::move(slot.value_);
+    slot.value_            = carry;
+    if (total)
+    {
+      carry.emplace(carry ? op(std::move(*carry), std::move(*total)) : std::move(*total));
+    }
+  }
+
+  auto scan_batch = [&](uint32_t batch, worker_context const& /*unused*/)
+  {
+    scan(std::move(slots[batch].value_), layout.get_begin(batch), layout.get_end(batch, count));
+  };
+  ouly::detail::run_batches(this_context, layout.batch_count_, scan_batch);
+}
+
+template <typename FwIt>
+using scan_value_t = std::decay_t<decltype(get_element(std::begin(std::declval<FwIt const&>())))>;
+
+} // namespace ouly::detail
+
+namespace ouly
+{
+
+/**
+ * @brief Inclusive prefix scan of a range in parallel, out[i] = in[0] op ... op in[i]
+ *
+ * Uses a two pass blocked scan over batches laid out following the task traits, batch totals and carries live in cache
+ * line padded slots. Every element is read twice, op must be associative.
+ *
+ * @param range Input range, or an integer_range
+ * @param out Random access output iterator, may point to the beginning of the input range
+ *
+ * @code
+ *   ouly::parallel_inclusive_scan(std::span(counts), offsets.begin(), std::plus<>(), ouly::default_workgroup_id);
+ * @endcode
+ */
+template <typename FwIt, typename OutIt, typename BinaryOp, typename TaskTr = default_task_traits>
+void parallel_inclusive_scan(FwIt const& range, OutIt out, BinaryOp op, worker_context const& this_context,
+                             TaskTr /*unused*/ = {})
+{
+  using value_type = ouly::detail::scan_value_t<FwIt>;
+  ouly::detail::parallel_scan<true, value_type, FwIt, OutIt, BinaryOp, TaskTr>(range, out, std::nullopt, std::move(op),
+                                                                              this_context);
+}
+
+template <typename FwIt, typename OutIt, typename BinaryOp, typename TaskTr = default_task_traits>
+void parallel_inclusive_scan(FwIt const& range, OutIt out, BinaryOp op, workgroup_id workgroup, TaskTr tt = {})
+{
+  parallel_inclusive_scan(range, out, std::move(op), worker_context::get(workgroup), tt);
+}
+
+/**
+ * @brief Exclusive prefix scan of a range in parallel, out[0] = init, out[i] = init op in[0] op ... op in[i - 1]
+ *
+ * @see parallel_inclusive_scan
+ */
+template <typename T, typename FwIt, typename OutIt, typename BinaryOp, typename TaskTr = default_task_traits>
+void parallel_exclusive_scan(FwIt const& range, OutIt out, T init, BinaryOp op, worker_context const& this_context,
+                             TaskTr /*unused*/ = {})
+{
+  ouly::detail::parallel_scan<false, T, FwIt, OutIt, BinaryOp, TaskTr>(range, out, std::move(init), std::move(op),
+                                                                      this_context);
+}
+
+template <typename T, typename FwIt, typename OutIt, typename BinaryOp, typename TaskTr = default_task_traits>
+void parallel_exclusive_scan(FwIt const& range, OutIt out, T init, BinaryOp op, workgroup_id workgroup,
+                             TaskTr tt = {})
+{
+  parallel_exclusive_scan(range, out, std::move(init), std::move(op), worker_context::get(workgroup), tt);
+}
+
+} // namespace ouly
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "ouly/scheduler/detail/parallel_executer.hpp"
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace ouly::detail
+{
+
+/**
+ * @brief Runs sorted by insertion before the buffered stable sort starts merging
+ */
+constexpr uint32_t stable_sort_run_size = 32;
+
+/**
+ * @brief Stable merge sort of [first, last) using buffer, of at least the same size, instead of allocating like
+ * std::stable_sort does. The result ends in [first, last).
+ */
+template <typename T, typename Compare>
+void buffered_stable_sort(T* first, T* last, T* buffer, Compare& comp)
+{
+  auto count = static_cast<uint32_t>(last - first);
+  for (uint32_t begin = 0; begin < count; begin += stable_sort_run_size)
+  {
+    auto end = std::min(begin + stable_sort_run_size, count);
+    for (auto i = begin + 1; i < end; ++i)
+    {
+      T    value = std::move(first[i]);
+      auto j     = i;
+      for (; j > begin && comp(value, first[j - 1]); --j)
+      {
+        first[j] = std::move(first[j - 1]);
+      }
+      first[j] = std::move(value);
+    }
+  }
+
+  T* src = first;
+  T* dst = buffer;
+  for (uint32_t width = stable_sort_run_size; width < count; width *= 2)
+  {
+    for (uint32_t begin = 0; begin < count; begin += 2 * width)
+    {
+      auto mid = std::min(begin + width, count);
+      auto end = std::min(begin + 2 * width, count);
+      std::merge(std::make_move_iterator(src + begin), std::make_move_iterator(src + mid),
+                 std::make_move_iterator(src + mid), std::make_move_iterator(src + end), dst + begin, comp);
+    }
+    std::swap(src, dst);
+  }
+
+  if (src != first)
+  {
+    std::move(src, src + count, first);
+  }
+}
+
+/**
+ * @brief Number of elements of a that precede output position k when merging a and b, elements of a go first on ties
+ */
+template <typename T, typename Compare>
+auto merge_co_rank(T const* a, uint32_t a_size, T const* b, uint32_t b_size, uint32_t k, Compare& comp) -> uint32_t
+{
+  uint32_t low  = k > b_size ? k - b_size : 0;
+  uint32_t high = std::min(k, a_size);
+  while (low < high)
+  {
+    auto mid = low + ((high - low) / 2);
+    if (!comp(b[k - mid - 1], a[mid]))
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * @brief Merge sort on top of the batch executer.
+ *
+ * Every batch is sorted on its own, then sorted runs are merged pairwise until one run is left, ping-ponging between
+ * the range and the scratch buffer. Each merge pass splits the output, not the runs, into batches and locates the input
+ * of every output batch with a binary search (merge path), so the last passes that merge a few long runs keep all
+ * workers busy. The merge is stable, the sort is stable when the batches are sorted with a stable sort.
+ */
+template <bool Stable, typename T, typename Compare, typename TaskTr>
+void parallel_sort(std::span<T> range, std::span<T> scratch, Compare& comp, worker_context const& this_context)
+{
+  using traits    = ouly::detail::final_task_traits<TaskTr>;
+  using size_type = uint32_t;
+
+  auto count  = static_cast<size_type>(range.size());
+  auto layout = ouly::detail::get_batch_layout<traits>(
+   this_context.get_scheduler().get_worker_count(this_context.get_workgroup()), count);
+
+  std::vector<T> owned;
+  if (scratch.size() < count && (Stable || layout.batch_count_ > 1))
+  {
+    owned.resize(count);
+    scratch = owned;
+  }
+
+  auto sort_run = [&](size_type begin, size_type end)
+  {
+    if constexpr (Stable)
+    {
+      ouly::detail::buffered_stable_sort(range.data() + begin, range.data() + end, scratch.data() + begin, comp);
+    }
+    else
+    {
+      std::sort(range.data() + begin, range.data() + end, comp);
+    }
+  };
+
+  if (count <= traits::parallel_execution_threshold || layout.batch_count_ <= 1)
+  {
+    sort_run(0, count);
+    return;
+  }
+
+  auto sort_batch = [&](uint32_t batch, worker_context const& /*unused*/)
+  {
+    sort_run(layout.get_begin(batch), layout.get_end(batch, count));
+  };
+  ouly::detail::run_batches(this_context, layout.batch_count_, sort_batch);
+
+  T* src = range.data();
+  T* dst = scratch.data();
+  for (size_type width = layout.batch_size_; width < count; width *= 2)
+  {
+    auto merge_batch = [&](uint32_t batch, worker_context const& /*unused*/)
+    {
+      // An output batch can span the end of one pair of runs and the start of the next
+      for (auto out = layout.get_begin(batch), out_end = layout.get_end(batch, count); out < out_end;)
+      {
+        auto pair_begin = out - (out % (2 * width));
+        auto pair_mid   = std::min(pair_begin + width, count);
+        auto pair_end   = std::min(pair_begin + (2 * width), count);
+        auto last       = std::min(out_end, pair_end);
+
+        auto const* a      = src + pair_begin;
+        auto const* b      = src + pair_mid;
+        auto        a_size = pair_mid - pair_begin;
+        auto        b_size = pair_end - pair_mid;
+        auto        a_from = ouly::detail::merge_co_rank(a, a_size, b, b_size, out - pair_begin, comp);
+        auto        a_to   = ouly::detail::merge_co_rank(a, a_size, b, b_size, last - pair_begin, comp);
+        auto        b_from = out - pair_begin - a_from;
+        auto        b_to   = last - pair_begin - a_to;
+
+        std::merge(std::make_move_iterator(src + pair_begin + a_from), std::make_move_iterator(src + pair_begin + a_to),
+                   std::make_move_iterator(src + pair_mid + b_from), std::make_move_iterator(src + pair_mid + b_to),
+                   dst + out, comp);
+        out = last;
+      }
+    };
+    ouly::detail::run_batches(this_context, layout.batch_count_, merge_batch);
+    std::swap(src, dst);
+  }
+
+  if (src != range.data())
+  {
+    auto move_back = [&](uint32_t batch, worker_context const& /*unused*/)
+    {
+      std::move(src + layout.get_begin(batch), src + layout.get_end(batch, count),
+                range.data() + layout.get_begin(batch));
+    };
+    ouly::detail::run_batches(this_context, layout.batch_count_, move_back);
+  }
+}
+
+} // namespace ouly::detail
+
+namespace ouly
+{
+
+/**
+ * @brief Sort a contiguous range in parallel, not stable
+ *
+ * Batches laid out following the task traits are sorted with std::sort, and then merged in parallel passes. Ranges up
+ * to parallel_execution_threshold elements are sorted serially on the calling worker.
+ *
+ * @param range Elements to sort
+ * @param scratch Buffer holding at least as many elements as the range, its contents are overwritten. A buffer kept
+ * across calls avoids the allocation of a temporary one when it is too small.
+ * @param comp Strict weak ordering, as for std::sort
+ *
+ * @code
+ *   std::vector<uint64_t> scratch(keys.size());
+ *   ouly::parallel_sort(std::span(keys), scratch, std::less<>(), ouly::default_workgroup_id);
+ * @endcode
+ *
+ * @note T must be move assignable, and default constructible when no sufficient scratch buffer is given.
+ */
+template <typename T, typename Compare, typename TaskTr = default_task_traits>
+void parallel_sort(std::span<T> range, std::type_identity_t<std::span<T>> scratch, Compare comp,
+                   worker_context const& this_context, TaskTr /*unused*/ = {})
+{
+  ouly::detail::parallel_sort<false, T, Compare, TaskTr>(range, scratch, comp, this_context);
+}
+
+template <typename T, typename Compare, typename TaskTr = default_task_traits>
+void parallel_sort(std::span<T> range, std::type_identity_t<std::span<T>> scratch, Compare comp,
+                   workgroup_id workgroup, TaskTr tt = {})
+{
+  parallel_sort(range, scratch, std::move(comp), worker_context::get(workgroup), tt);
+}
+
+/**
+ * @brief Sort a contiguous range in parallel, a temporary scratch buffer is allocated
+ */
+template <typename T, typename Compare, typename TaskTr = default_task_traits>
+void parallel_sort(std::span<T> range, Compare comp, worker_context const& this_context, TaskTr tt = {})
+{
+  parallel_sort(range, std::span<T>(), std::move(comp), this_context, tt);
+}
+
+template <typename T, typename Compare, typename TaskTr = default_task_traits>
+void parallel_sort(std::span<T> range, Compare comp, workgroup_id workgroup, TaskTr tt = {})
+{
+  parallel_sort(range, std::span<T>(), std::move(comp), worker_context::get(workgroup), tt);
+}
+
+/**
+ * @brief Sort a contiguous range in parallel, equal elements keep their order
+ *
+ * Batches are sorted with a merge sort that works in the scratch buffer instead of allocating like std::stable_sort,
+ * and then merged in parallel passes. The serial path under parallel_execution_threshold needs the scratch buffer too.
+ *
+ * @see parallel_sort
+ */
+template <typename T, typename Compare, typename TaskTr = default_task_traits>
+void parallel_stable_sort(std::span<T> range, std::type_identity_t<std::span<T>> scratch, Compare comp,
+                          worker_context const& this_context, TaskTr /*unused*/ = {})
+{
+  ouly::detail::parallel_sort<true, T, Compare, TaskTr>(range, scratch, comp, this_context);
+}
+
+template <typename T, typename Compare, typename TaskTr = default_task_traits>
+void parallel_stable_sort(std::span<T> range, std::type_identity_t<std::span<T>> scratch, Compare comp,
+                          workgroup_id workgroup, TaskTr tt = {})
+{
+  parallel_stable_sort(range, scratch, std::move(comp), worker_context::get(workgroup), tt);
+}
+
+template <typename T, typename Compare, typename TaskTr = default_task_traits>
+void parallel_stable_sort(std::span<T> range, Compare comp, worker_context const& this_context, TaskTr tt = {})
+{
+  parallel_stable_sort(range, std::span<T>(), std::move(comp), this_context, tt);
+}
+
+template <typename T, typename Compare, typename TaskTr = default_task_traits>
+void parallel_stable_sort(std::span<T> range, Compare comp, workgroup_id workgroup, TaskTr tt = {})
+{
+  parallel_stable_sort(range, std::span<T>(), std::move(comp), worker_context::get(workgroup), tt);
+}
+
+} // namespace ouly
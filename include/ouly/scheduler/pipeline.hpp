@@ -0,0 +1,172 @@
+#pragma once
+
+#include "ouly/scheduler/event_types.hpp"
+#include "ouly/scheduler/scheduler.hpp"
+#include "ouly/scheduler/spin_lock.hpp"
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace ouly
+{
+
+/**
+ * @brief How a pipeline stage processes the tokens that reach it
+ */
+enum class stage_mode : uint8_t
+{
+  /**
+   * Any number of tokens are processed at the same time
+   */
+  parallel,
+  /**
+   * One token at a time, in the order the input stage produced them
+   */
+  serial_in_order,
+  /**
+   * One token at a time, in the order they reach the stage
+   */
+  serial_out_of_order,
+};
+
+/**
+ * @brief A chain of stages executed on a scheduler, with a bounded number of items in flight
+ *
+ * The input stage produces one item per call until it returns false, every item then passes through the stages in the
+ * order they were added. Items are identified by a token, an index below the max_tokens given at construction, so the
+ * data of an item lives in storage owned by the caller and indexed by the token. At most max_tokens items are in
+ * flight, the input stage is not called again until the last stage has released a token, which caps the memory used
+ * while every stage keeps running as long as items are available.
+ *
+ * Every stage runs on its own workgroup. The input stage is serial, serial stages process one token at a time and keep
+ * a worker on the stage while tokens are waiting for it. Executing a pipeline does not allocate.
+ *
+ * Example usage:
+ * @code
+ * std::array<chunk, 8> chunks;
+ * ouly::pipeline ingest(8);
+ * ingest.set_input(io_group,
+ *                  [&](uint32_t token, ouly::worker_context const&) { return read_next(file, chunks[token]); });
+ * ingest.add_stage(ouly::stage_mode::parallel, ouly::default_workgroup_id,
+ *                  [&](uint32_t token, ouly::worker_context const&) { compress(chunks[token]); });
+ * ingest.add_stage(ouly::stage_mode::serial_in_order, io_group,
+ *                  [&](uint32_t token, ouly::worker_context const&) { write(out, chunks[token]); });
+ *
+ * ingest.run(ouly::worker_context::get(ouly::default_workgroup_id));
+ * @endcode
+ *
+ * @note A pipeline can only be executed once at a time, and must not be modified while executing.
+ */
+class pipeline
+{
+public:
+  // Stages live in the pipeline and not in the work queues, they can capture more than a task
+  static constexpr uint32_t max_stage_size = 64;
+
+  using input_delegate = ouly::basic_delegate<max_stage_size, bool(uint32_t, worker_context const&)>;
+  using stage_delegate = ouly::basic_delegate<max_stage_size, void(uint32_t, worker_context const&)>;
+
+  OULY_API explicit pipeline(uint32_t max_tokens);
+  pipeline(const pipeline&)                    = delete;
+  pipeline(pipeline&&)                         = delete;
+  auto operator=(const pipeline&) -> pipeline& = delete;
+  auto operator=(pipeline&&) -> pipeline&      = delete;
+  ~pipeline() noexcept                         = default;
+
+  /**
+   * @brief Set the input stage, called with a free token it fills the token's item and returns true, or returns false
+   * once there is no more input
+   */
+  template <typename Lambda>
+    requires(ouly::detail::Callable<Lambda, uint32_t, ouly::worker_context const&>)
+  void set_input(workgroup_id group, Lambda&& input)
+  {
+    set_input(group, input_delegate::bind(std::forward<Lambda>(input)));
+  }
+
+  OULY_API void set_input(workgroup_id group, input_delegate input);
+
+  /**
+   * @brief Append a stage executing a lambda on the given workgroup, called with the token of the item to process
+   */
+  template <typename Lambda>
+    requires(ouly::detail::Callable<Lambda, uint32_t, ouly::worker_context const&>)
+  void add_stage(stage_mode mode, workgroup_id group, Lambda&& stage_fn)
+  {
+    add_stage(mode, group, stage_delegate::bind(std::forward<Lambda>(stage_fn)));
+  }
+
+  OULY_API void add_stage(stage_mode mode, workgroup_id group, stage_delegate stage_fn);
+
+  /**
+   * @brief Start pulling items from the input stage, returns immediately
+   */
+  OULY_API void start(worker_context const& ctx) noexcept;
+
+  /**
+   * @brief Wait for the input to run dry and every item to leave the last stage, the waiting worker executes other work
+   * meanwhile
+   */
+  OULY_API void wait(worker_context const& ctx);
+
+  /**
+   * @brief Execute the pipeline and wait for it to finish
+   */
+  void run(worker_context const& ctx)
+  {
+    start(ctx);
+    wait(ctx);
+  }
+
+  [[nodiscard]] auto get_max_tokens() const noexcept -> uint32_t
+  {
+    return max_tokens_;
+  }
+
+  [[nodiscard]] auto get_stage_count() const noexcept -> uint32_t
+  {
+    return static_cast<uint32_t>(stages_.size());
+  }
+
+private:
+  static constexpr uint32_t no_token = std::numeric_limits<uint32_t>::max();
+
+  struct stage
+  {
+    stage_delegate  fn_;
+    workgroup_id    group_;
+    stage_mode      mode_;
+    ouly::spin_lock lock_;
+    // Tokens waiting for a serial stage, indexed by sequence for in order stages and a ring otherwise
+    std::unique_ptr<uint32_t[]> waiting_;
+    uint32_t                    next_sequence_ = 0;
+    uint32_t                    head_          = 0;
+    uint32_t                    tail_          = 0;
+    bool                        busy_          = false;
+  };
+
+  void submit_input(worker_context const& ctx) noexcept;
+  void run_input(worker_context const& ctx) noexcept;
+  void forward(worker_context const& ctx, uint32_t token, uint32_t stage_index) noexcept;
+  void execute_stage(worker_context const& ctx, uint32_t token, uint32_t stage_index) noexcept;
+  void release_token(worker_context const& ctx, uint32_t token) noexcept;
+  auto take_waiting(stage& s) noexcept -> uint32_t;
+
+  input_delegate                      input_;
+  workgroup_id                        input_group_ = default_workgroup_id;
+  std::vector<std::unique_ptr<stage>> stages_;
+  // Input sequence of the item held by every token
+  std::unique_ptr<uint32_t[]> sequences_;
+  std::unique_ptr<uint32_t[]> free_tokens_;
+  uint32_t                    max_tokens_ = 0;
+  uint32_t                    next_input_ = 0;
+
+  ouly::spin_lock lock_;
+  uint32_t        free_count_   = 0;
+  uint32_t        in_flight_    = 0;
+  bool            input_active_ = false;
+  bool            input_done_   = false;
+  busywork_event  done_;
+};
+
+} // namespace ouly
@@ -1,8 +1,17 @@
 #pragma once
+#include "ouly/scheduler/cancellation.hpp"
+#include "ouly/scheduler/cpu_topology.hpp"
+#include "ouly/scheduler/detail/timer_wheel.hpp"
 #include "ouly/scheduler/detail/worker.hpp"
+#include "ouly/scheduler/scheduler_options.hpp"
+#include "ouly/scheduler/scheduler_stats.hpp"
+#include "ouly/scheduler/trace.hpp"
 #include "ouly/utility/config.hpp"
 #include "ouly/utility/type_traits.hpp"
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <span>
 #include <thread>
 
 namespace ouly
@@ -52,6 +61,7 @@ static constexpr uint32_t default_logical_task_divisior = 64;
  * - Worker thread management and work stealing
  * - Priority-based scheduling between workgroups
  * - Thread affinity control via workgroup thread offset/count
+ * - Choice between spin-lock protected shared queues and lock-free work stealing deques, see scheduler_options
  *
  * Common workgroup configurations:
  * - Default group: General purpose work
@@ -61,7 +71,7 @@ static constexpr uint32_t default_logical_task_divisior = 64;
  * - Stream group: Media streaming tasks
  *
  * @note The scheduler must be started with begin_execution() before submitting tasks
- * @note Work group creation is frozen after begin_execution() is called
+ * @note Work group creation is frozen after begin_execution() is called, resize_group() moves existing groups
  * @note Only one scheduler should be active at a time, use take_ownership() if multiple exist
  */
 class scheduler
@@ -70,7 +80,11 @@ class scheduler
 public:
   static constexpr uint32_t work_scale = 4;
 
-  OULY_API scheduler() noexcept                  = default;
+  OULY_API scheduler() noexcept = default;
+  /**
+   * @brief Construct a scheduler with the given options, options cannot be changed after construction
+   */
+  OULY_API explicit scheduler(scheduler_options const& options) noexcept : options_(options) {}
   OULY_API scheduler(const scheduler&)           = delete;
   scheduler(scheduler&&)                         = delete;
   auto operator=(const scheduler&) -> scheduler& = delete;
@@ -125,6 +139,56 @@ public:
     submit(src, group, ouly::detail::work_item::pbind(std::forward<Lambda>(data), group));
   }
 
+  /**
+   * @brief Submits a work item bound to a cancellation token, the worker that dequeues it skips it if the token was
+   * cancelled meanwhile.
+   *
+   * @note The lambda is stored next to the pointer sized token, its captures must fit in 8 bytes, capture a single
+   * pointer to larger state
+   */
+  template <typename Lambda>
+    requires(ouly::detail::Callable<Lambda, ouly::worker_context const&>)
+  void submit(worker_id src, workgroup_id group, cancellation_token token, Lambda&& data) noexcept
+  {
+    auto checked = [token, fn = std::forward<Lambda>(data)](worker_context const& ctx) mutable
+    {
+      if (!token.is_cancelled())
+      {
+        fn(ctx);
+      }
+    };
+    // The work item shares max_task_base_size bytes between the wrapper and its workgroup, the token and the padding to
+    // its alignment leave 8 bytes for the captures
+    static_assert(sizeof(checked) <= ouly::max_task_base_size - sizeof(workgroup_id),
+                  "Cancellable lambda captures exceed 8 bytes, capture a pointer to larger state");
+    submit(src, group, ouly::detail::work_item::pbind(std::move(checked), group));
+  }
+
+  /**
+   * @brief Submits a coroutine task bound to a cancellation token. If the token is cancelled before a worker resumes
+   * the task, it completes without running and whoever awaits it resumes with a value initialized result, see
+   * co_task::is_cancelled.
+   */
+  template <CancellableTask C>
+  void submit(worker_id src, workgroup_id group, cancellation_token token, C const& task_obj) noexcept
+  {
+    submit(src, group,
+           ouly::detail::work_item::pbind(
+            [address = task_obj.address(), token](worker_context const&)
+            {
+              auto coro = C::handle::from_address(address);
+              if (token.is_cancelled())
+              {
+                coro.promise().cancel();
+              }
+              else
+              {
+                coro.resume();
+              }
+            },
+            group));
+  }
+
   /**
    * @brief Submits a member function to be executed as a work item in the scheduler
    *
@@ -299,6 +363,10 @@ public:
 
   /**
    * @brief Submit a work for execution in the exclusive worker thread
+   *
+   * The item is linked into the destination worker's lock-free mailbox with a node taken from the source worker's pool,
+   * producers never contend with the destination, which checks its mailbox with a single relaxed load. When the calling
+   * thread is not src, ie. an external thread, the node comes from a shared pool guarded by a lock instead.
    */
   OULY_API void submit(worker_id src, worker_id dst, ouly::detail::work_item work);
 
@@ -307,6 +375,198 @@ public:
    */
   OULY_API void submit(worker_id src, workgroup_id dst, ouly::detail::work_item work);
 
+  /**
+   * @brief Submit a work for execution in a priority lane of the group.
+   *
+   * task_priority::normal behaves like the overload without a priority. High priority items are handed to a sleeping
+   * worker of the group if there is one, otherwise they wait in the high lane of the shared queues, which workers check
+   * before their own queue. Low priority items wait in the low lane and are only taken when nothing else is pending, or
+   * when a worker ages its lanes, see scheduler_options::priority_aging.
+   */
+  OULY_API void submit(worker_id src, workgroup_id dst, ouly::detail::work_item work, task_priority priority);
+
+  /**
+   * @brief Submit a work item from a thread that is not a worker of this scheduler, ie. an io completion thread. The
+   * item is handed to a sleeping worker of the group, or pushed into the group's shared queues.
+   */
+  OULY_API void submit_external(workgroup_id dst, ouly::detail::work_item work);
+
+  /**
+   * @brief Submit a work item from any thread, through submit when the calling thread is a worker of this scheduler and
+   * submit_external otherwise
+   */
+  OULY_API void submit_any(workgroup_id dst, ouly::detail::work_item work);
+
+  /**
+   * @brief Submits a lambda to a priority lane of a workgroup
+   * @see submit(worker_id, workgroup_id, ouly::detail::work_item, task_priority)
+   */
+  template <typename Lambda>
+    requires(ouly::detail::Callable<Lambda, ouly::worker_context const&>)
+  void submit(worker_id src, workgroup_id group, Lambda&& data, task_priority priority) noexcept
+  {
+    submit(src, group, ouly::detail::work_item::pbind(std::forward<Lambda>(data), group), priority);
+  }
+
+  /**
+   * @brief Submits a coroutine task to a priority lane of a workgroup
+   * @see submit(worker_id, workgroup_id, ouly::detail::work_item, task_priority)
+   */
+  template <CoroutineTask C>
+  void submit(worker_id src, workgroup_id group, C const& task_obj, task_priority priority) noexcept
+  {
+    submit(src, group,
+           ouly::detail::work_item::pbind(
+            [address = task_obj.address()](worker_context const&)
+            {
+              std::coroutine_handle<>::from_address(address).resume();
+            },
+            group),
+           priority);
+  }
+
+  /**
+   * @brief Submits a batch of generated work items to a workgroup
+   *
+   * @tparam Generator Callable returning the work item for a given index in [0, count)
+   * @param src ID of the worker submitting the batch
+   * @param dst Workgroup the items are submitted to
+   * @param count Number of items in the batch
+   * @param generator Called once per item, possibly under a queue lock, so it should only build the work item
+   *
+   * @details When src is the calling worker and a member of dst, items go into its own deque or local ring until it is
+   * full, as submit does. The rest is spread evenly across the group's shared queues, taking every queue lock once.
+   * At most as many sleeping workers are then woken up as there are items.
+   */
+  template <typename Generator>
+    requires(std::is_invocable_r_v<ouly::detail::work_item, Generator&, uint32_t>)
+  void submit_batch(worker_id src, workgroup_id dst, uint32_t count, Generator&& generator) noexcept
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    bool external = !is_worker_thread();
+    if (external)
+    {
+      enter_external();
+    }
+
+    auto&    wg        = workgroups_[dst.get_index()];
+    uint32_t next      = 0;
+    uint32_t occupancy = 0;
+    if (is_current_worker(src) && (group_ranges_[src.get_index()].mask_ & (1U << dst.get_index())) != 0U)
+    {
+      auto own = src.get_index() - wg.start_thread_idx_;
+      while (next < count)
+      {
+        ouly::detail::work_item item = generator(next++);
+        if (!(wg.work_deques_ ? wg.work_deques_[own].try_push(item) : wg.local_queues_[own].try_push(item)))
+        {
+          push_shared(wg, std::move(item), task_priority::normal);
+          break;
+        }
+      }
+      occupancy = wg.work_deques_ ? wg.work_deques_[own].size() : wg.local_queues_[own].size();
+    }
+
+    if (next < count)
+    {
+      uint32_t spilled   = count - next;
+      uint32_t per_queue = (spilled + wg.thread_count_ - 1) / wg.thread_count_;
+      uint32_t offset    = wg.shared_->push_offset_.fetch_add(1, std::memory_order_relaxed);
+      for (uint32_t q = 0; q < wg.thread_count_ && next < count; ++q)
+      {
+        auto& queue = wg.work_queues_[(offset + q) % wg.thread_count_];
+        auto  lck   = std::scoped_lock(queue.lock_);
+        auto& lane  = queue.get_lane(task_priority::normal);
+        auto  end   = std::min(next + per_queue, count);
+        queue.size_.fetch_add(end - next, std::memory_order_relaxed);
+        for (; next < end; ++next)
+        {
+          lane.emplace_back(generator(next));
+        }
+      }
+      wg.shared_->items_.fetch_add(spilled, std::memory_order_relaxed);
+      occupancy = std::max(occupancy, per_queue);
+    }
+
+    // Order the pushes before the relaxed status loads, as in needs_wake
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t wake_count = count;
+    for (uint32_t i = wg.start_thread_idx_, end = i + wg.thread_count_; i != end && wake_count > 0; ++i)
+    {
+      if (options_.elastic.enabled && !needs_wake(wg, occupancy))
+      {
+        break;
+      }
+      if (i != src.get_index() && !wake_status_[i].load(std::memory_order_relaxed) && !wake_status_[i].exchange(true))
+      {
+        wake_events_[i].notify();
+        wake_count--;
+      }
+    }
+
+    if (external)
+    {
+      leave_external();
+    }
+  }
+
+  /**
+   * @brief Submits a batch of work items to a workgroup, see the generator overload of submit_batch
+   */
+  void submit_batch(worker_id src, workgroup_id dst, std::span<ouly::detail::work_item const> items) noexcept
+  {
+    submit_batch(src, dst, static_cast<uint32_t>(items.size()),
+                 [items](uint32_t i)
+                 {
+                   return items[i];
+                 });
+  }
+
+  /**
+   * @brief Submit a work item to a workgroup once the delay has elapsed.
+   *
+   * Timers live in a timer wheel owned by the scheduler, idle workers fire due timers before they park and park no
+   * longer than the next deadline, so no extra thread is involved. Deadlines are rounded up to
+   * scheduler_options::timer_tick. Pending timers are dropped by end_execution. Timer nodes are allocated in blocks as
+   * the wheel grows, so this can throw std::bad_alloc.
+   *
+   * @return A handle that can be passed to cancel_timer
+   *
+   * @code
+   * scheduler.submit_after(std::chrono::milliseconds(5), io_group, [](ouly::worker_context const& ctx) { retry(); });
+   * @endcode
+   */
+  template <typename Rep, typename Period, typename Lambda>
+    requires(ouly::detail::Callable<Lambda, ouly::worker_context const&>)
+  auto submit_after(std::chrono::duration<Rep, Period> delay, workgroup_id group, Lambda&& data) -> timer_id
+  {
+    return add_timer(std::chrono::ceil<std::chrono::nanoseconds>(delay), std::chrono::nanoseconds::zero(),
+                     ouly::detail::work_item::pbind(std::forward<Lambda>(data), group));
+  }
+
+  /**
+   * @brief Submit a work item to a workgroup every period, starting one period from now, until cancel_timer is called.
+   * Periods missed because no worker was available are skipped rather than fired in a burst.
+   * @see submit_after
+   */
+  template <typename Rep, typename Period, typename Lambda>
+    requires(ouly::detail::Callable<Lambda, ouly::worker_context const&>)
+  auto submit_every(std::chrono::duration<Rep, Period> period, workgroup_id group, Lambda&& data) -> timer_id
+  {
+    auto interval = std::chrono::ceil<std::chrono::nanoseconds>(period);
+    return add_timer(interval, interval, ouly::detail::work_item::pbind(std::forward<Lambda>(data), group));
+  }
+
+  /**
+   * @brief Cancel a pending timer, returns false if it already fired or was cancelled. A periodic timer's work that is
+   * already submitted still runs.
+   */
+  OULY_API auto cancel_timer(timer_id timer) noexcept -> bool;
+
   /**
    * @brief Begin scheduler execution, group creation is frozen after this call.
    * @param entry An entry function can be provided that will be executed on all worker threads upon entry.
@@ -335,6 +595,35 @@ public:
    * group is executed first by the thread
    */
   OULY_API auto create_group(uint32_t thread_offset, uint32_t thread_count, uint32_t priority = 0) -> workgroup_id;
+  /**
+   * @brief Create a work-group with one worker per given logical cpu, worker thread_offset + i is pinned to cpus[i]
+   * when execution begins. Workers of the group steal from workers sharing their L3 first, then from workers on the
+   * same NUMA node, then from the rest of the group.
+   *
+   * Use cpu_topology::get_physical_cores(node) to get one worker per physical core, or get_logical_cpus(node) to use
+   * every hardware thread. If the group contains worker 0, the thread calling begin_execution is pinned.
+   *
+   * @note Groups sharing workers must agree on the cpu of the shared workers
+   */
+  OULY_API void create_group(workgroup_id group, uint32_t thread_offset, cpu_topology const& topology,
+                             std::span<uint32_t const> cpus, uint32_t priority = 0);
+  /**
+   * @brief Move a work-group to a different range of workers.
+   *
+   * Before begin_execution this is the same as create_group. While the scheduler is running, every worker finishes
+   * the item it is executing and pauses, the group's queues are rebuilt for the new range and the items still queued
+   * in the old ones are moved over, then the workers resume. The range must lie within the workers created by
+   * begin_execution.
+   *
+   * @note Must be called from the main thread outside of any work item, and not while a running item waits for the
+   * main thread.
+   */
+  OULY_API void resize_group(workgroup_id group, uint32_t thread_offset, uint32_t thread_count);
+  /**
+   * @brief Change which group shared workers serve first, can be called while the scheduler is running
+   * @see resize_group
+   */
+  OULY_API void set_group_priority(workgroup_id group, uint32_t priority);
   /**
    * @brief Clear a group, and re-create it
    */
@@ -373,14 +662,95 @@ public:
    * scheduler
    */
   OULY_API void take_ownership() noexcept;
-  OULY_API void busy_work(worker_id /*thread*/) noexcept;
+
+  /**
+   * @brief Execute at most one pending work item on the given worker, returns false if no work was found
+   */
+  OULY_API auto busy_work(worker_id /*thread*/) noexcept -> bool;
+
+  /**
+   * @brief Check if a worker's own queue in a workgroup still holds work, pushed by it and not yet taken by others
+   */
+  [[nodiscard]] auto has_local_work(worker_id worker, workgroup_id group) const noexcept -> bool
+  {
+    auto const& wg     = workgroups_[group.get_index()];
+    auto        offset = worker.get_index() - wg.start_thread_idx_;
+    if (offset >= wg.thread_count_)
+    {
+      return false;
+    }
+    if (wg.work_deques_)
+    {
+      return !wg.work_deques_[offset].empty();
+    }
+    return wg.local_queues_ && !wg.local_queues_[offset].empty();
+  }
+
+  /**
+   * @brief Read the idle counters of a worker, can be called while the scheduler is running
+   */
+  [[nodiscard]] OULY_API auto get_idle_stats(worker_id worker) const noexcept -> worker_idle_stats;
+
+  /**
+   * @brief Snapshot the counters of every worker. Workers keep running, counters are read relaxed, so values of
+   * different counters may be a few events apart.
+   */
+  [[nodiscard]] OULY_API auto collect_stats() const -> scheduler_stats;
+
+  /**
+   * @brief Collect the events every worker recorded since the last drain, sorted by timestamp. Always empty unless
+   * built with OULY_SCHEDULER_TRACE. Can be called while the scheduler is running, but only from one thread at a time.
+   */
+  [[nodiscard]] OULY_API auto drain_trace() -> std::vector<trace_event>;
+
+  /**
+   * @brief Drain the trace and write it as Chrome trace_event JSON
+   * @see drain_trace, ouly::write_chrome_trace
+   */
+  OULY_API void write_chrome_trace(std::ostream& out);
 
 private:
   void        finish_pending_tasks() noexcept;
+  void        reconfigure_group(workgroup_id /*group*/, uint32_t /*thread_offset*/, uint32_t /*thread_count*/,
+                                uint32_t /*priority*/);
+  void        pause_workers() noexcept;
+  void        resume_workers() noexcept;
+  void        wait_for_resume(uint32_t /*epoch*/) noexcept;
+  void        init_group_queues(ouly::detail::workgroup& /*group*/) const;
+  void        build_group_ranges() noexcept;
+  void        build_contexts(void* /*user_context*/) noexcept;
   inline void do_work(worker_id /*thread*/, ouly::detail::work_item& /*work*/) noexcept;
   void        wake_up(worker_id /*thread*/) noexcept;
+  void        wake_up_one(ouly::detail::workgroup const& /*group*/, worker_id /*except*/) noexcept;
+  [[nodiscard]] OULY_API auto needs_wake(ouly::detail::workgroup const& /*group*/,
+                                         uint32_t /*occupancy*/) const noexcept -> bool;
   void        run(worker_id /*thread*/);
+  auto        spin_wait(worker_id /*thread*/) noexcept -> bool;
   auto        get_work(worker_id /*thread*/) noexcept -> ouly::detail::work_item;
+  static auto pop_shared(ouly::detail::workgroup& /*group*/, uint32_t /*offset*/,
+                         ouly::detail::worker_counters& /*stats*/, std::span<task_priority const> /*lanes*/) noexcept
+   -> ouly::detail::work_item;
+  OULY_API void push_shared(ouly::detail::workgroup& /*group*/, ouly::detail::work_item /*work*/,
+                            task_priority /*lane*/);
+  static auto steal_work(ouly::detail::workgroup& /*group*/, uint32_t /*offset*/) noexcept -> ouly::detail::work_item;
+  void        build_steal_order(ouly::detail::workgroup& /*group*/) const;
+  void        pin_worker(worker_id /*thread*/) const noexcept;
+  auto        poll_timers(worker_id /*thread*/) noexcept -> bool;
+  void        park(worker_id /*thread*/) noexcept;
+  // True when the calling thread runs the worker, owner only queues must not be pushed to from anywhere else
+  [[nodiscard]] OULY_API auto is_current_worker(worker_id /*thread*/) const noexcept -> bool;
+  // True when the calling thread runs any worker of this scheduler
+  [[nodiscard]] OULY_API auto is_worker_thread() const noexcept -> bool;
+  // A thread that is not a worker stays out of the queues between these calls while resize_group rebuilds them
+  OULY_API void      enter_external() noexcept;
+  OULY_API void      leave_external() noexcept;
+  [[nodiscard]] auto get_timer_tick() const noexcept -> uint64_t;
+  [[nodiscard]] auto get_timer_tick_length() const noexcept -> std::chrono::nanoseconds
+  {
+    return std::max(options_.timer_tick, std::chrono::nanoseconds(1));
+  }
+  OULY_API auto      add_timer(std::chrono::nanoseconds /*delay*/, std::chrono::nanoseconds /*period*/,
+                               ouly::detail::work_item /*work*/) -> timer_id;
 
   auto work(worker_id /*thread*/) noexcept -> bool;
 
@@ -396,9 +766,27 @@ private:
   std::unique_ptr<std::atomic_bool[]>          wake_status_;
   std::unique_ptr<ouly::detail::wake_event[]>  wake_events_;
   std::vector<std::thread>                     threads_;
-
-  uint32_t         worker_count_ = 0;
-  std::atomic_bool stop_         = false;
+  // Cpu each worker is pinned to, empty unless groups were created from a cpu topology
+  std::vector<cpu_info> worker_cpus_;
+  // Delayed and periodic work, guarded by timer_lock_, ticks count from timer_origin_
+  ouly::detail::timer_wheel             timers_;
+  ouly::spin_lock                       timer_lock_;
+  std::chrono::steady_clock::time_point timer_origin_;
+  // Mirror of timers_.next_deadline() readable without the lock
+  std::atomic_uint64_t next_timer_deadline_ = ouly::detail::timer_wheel::no_deadline;
+  // Mailbox nodes for submit(src, dst) calls made from a thread other than src, their owner index is worker_count_
+  ouly::detail::mailbox_pool external_mailbox_nodes_;
+  ouly::spin_lock            external_mailbox_lock_;
+
+  scheduler_options options_;
+  // Trace clock reading taken at begin_execution, trace timestamps are relative to it
+  ouly::detail::trace_clock_sample trace_origin_;
+  uint32_t                         worker_count_ = 0;
+  std::atomic_bool                 stop_         = false;
+  // Odd while resize_group rebuilds the queues, workers pause at the top of their loop until it changes
+  std::atomic_uint32_t reconfigure_epoch_ = 0;
+  std::atomic_uint32_t paused_workers_    = 0;
+  std::atomic_uint32_t external_submits_  = 0;
 };
 
 /**
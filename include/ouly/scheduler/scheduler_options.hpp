@@ -0,0 +1,141 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace ouly
+{
+
+/**
+ * @brief Selects how submitted work is queued inside a workgroup
+ */
+enum class work_queue_mode : uint8_t
+{
+  /**
+   * Every worker in a group owns a spin-lock protected queue, submissions are spread across the queues and workers
+   * try_lock their way through all of them looking for work.
+   */
+  shared_queues,
+  /**
+   * Every worker in a group owns a lock-free Chase-Lev deque. Work submitted by a worker into its own group is pushed
+   * at the bottom of its deque and popped back LIFO, idle workers steal FIFO from the top. Submissions from workers
+   * outside the group, or overflowing a full deque, go to the shared queues.
+   */
+  work_stealing,
+};
+
+/**
+ * @brief Priority lane of a work item inside its workgroup's shared queues
+ */
+enum class task_priority : uint8_t
+{
+  /**
+   * Latency critical work, taken before the worker's own queue and before any other lane
+   */
+  high,
+  /**
+   * Default lane of every submit without an explicit priority
+   */
+  normal,
+  /**
+   * Bulk work, only taken when the higher lanes are empty, or when the worker ages its lanes
+   */
+  low,
+};
+
+static constexpr uint32_t task_priority_count = 3;
+
+/**
+ * @brief Controls what an idle worker does before it parks on its wake event.
+ *
+ * A worker that finds no work first polls for work spin_iterations times, with an exponentially growing number of cpu
+ * pause instructions between polls (capped at max_pause_backoff), then polls yield_iterations times giving up its time
+ * slice between polls, and finally parks until a submit wakes it up. Spinning trades cpu time for wake-up latency, the
+ * default parks immediately.
+ */
+struct idle_policy
+{
+  static constexpr uint32_t default_max_pause_backoff = 64;
+
+  uint32_t spin_iterations   = 0;
+  uint32_t yield_iterations  = 0;
+  uint32_t max_pause_backoff = default_max_pause_backoff;
+};
+
+/**
+ * @brief Controls how many parked workers a submit wakes up.
+ *
+ * By default every submit wakes a parked worker of the group if there is one. With elastic parking enabled, a submit
+ * only wakes a worker when fewer than min_active workers of the group are awake, or when the queue it pushed into
+ * holds more than wake_threshold items per awake worker. At low load the surplus workers stay parked instead of
+ * cycling through empty queues, and they are woken one at a time as the backlog builds. High priority and
+ * worker-targeted submits always wake their worker.
+ */
+struct elastic_policy
+{
+  static constexpr uint32_t default_wake_threshold = 8;
+
+  bool     enabled        = false;
+  uint32_t min_active     = 1;
+  uint32_t wake_threshold = default_wake_threshold;
+};
+
+/**
+ * @brief Snapshot of a worker's idle counters, used to tune idle_policy
+ */
+struct worker_idle_stats
+{
+  // Polls for work made while spinning
+  uint64_t spin_polls = 0;
+  // Polls for work made while yielding
+  uint64_t yield_polls = 0;
+  // Idle periods that ended with work found while spinning
+  uint64_t spin_hits = 0;
+  // Idle periods that ended with work found while yielding
+  uint64_t yield_hits = 0;
+  // Number of times the worker parked on its wake event
+  uint64_t parks = 0;
+};
+
+/**
+ * @brief Construction time options of a scheduler, these cannot be changed once the scheduler is created.
+ */
+struct scheduler_options
+{
+  static constexpr uint32_t default_deque_capacity = 256;
+  static constexpr uint32_t default_trace_capacity = 16384;
+  static constexpr uint32_t default_priority_aging = 16;
+
+  /**
+   * Queueing strategy used by all workgroups
+   */
+  work_queue_mode queue_mode = work_queue_mode::shared_queues;
+  /**
+   * Capacity of a single worker's deque in work_queue_mode::work_stealing, rounded up to a power of 2
+   */
+  uint32_t deque_capacity = default_deque_capacity;
+  /**
+   * Idle behavior of all workers
+   */
+  idle_policy idle;
+  /**
+   * Wake up policy of all workgroups
+   */
+  elastic_policy elastic;
+  /**
+   * Every priority_aging-th look for work, a worker takes the low lane first and skips high priority preemption, so a
+   * steady stream of higher priority work cannot starve the lower lanes. 0 disables aging.
+   */
+  uint32_t priority_aging = default_priority_aging;
+  /**
+   * Number of events kept per worker when built with OULY_SCHEDULER_TRACE, rounded up to a power of 2. Older events are
+   * overwritten if the trace is not drained in time.
+   */
+  uint32_t trace_capacity = default_trace_capacity;
+  /**
+   * Resolution of submit_after and submit_every, timers fire on the first tick at or after their deadline
+   */
+  std::chrono::nanoseconds timer_tick = std::chrono::microseconds(100);
+};
+
+} // namespace ouly
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ouly/scheduler/scheduler_options.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace ouly
+{
+
+/**
+ * @brief Snapshot of a worker's counters since begin_execution
+ */
+struct worker_stats
+{
+  // Work items executed, indexed by workgroup
+  std::vector<uint64_t> tasks_executed;
+  // Items popped from the worker's own deque or local ring
+  uint64_t local_pops = 0;
+  // Items popped from the shared queues of its groups
+  uint64_t shared_pops = 0;
+  // Items stolen from other workers' deques or local rings
+  uint64_t stolen_pops = 0;
+  // Items popped from the worker's exclusive queue
+  uint64_t exclusive_pops = 0;
+  // Items handed over directly by a submitter that woke the worker up
+  uint64_t local_work_hits = 0;
+  // Non empty shared queues skipped in get_work because another thread held their lock
+  uint64_t failed_locks = 0;
+  // Total time spent parked on the wake event, in nanoseconds
+  uint64_t parked_ns = 0;
+  // Spin, yield and park counters
+  worker_idle_stats idle;
+
+  [[nodiscard]] auto get_tasks_executed() const noexcept -> uint64_t
+  {
+    uint64_t total = 0;
+    for (auto count : tasks_executed)
+    {
+      total += count;
+    }
+    return total;
+  }
+
+  auto operator+=(worker_stats const& other) -> worker_stats&
+  {
+    if (tasks_executed.size() < other.tasks_executed.size())
+    {
+      tasks_executed.resize(other.tasks_executed.size(), 0);
+    }
+    for (std::size_t g = 0; g < other.tasks_executed.size(); ++g)
+    {
+      tasks_executed[g] += other.tasks_executed[g];
+    }
+    local_pops += other.local_pops;
+    shared_pops += other.shared_pops;
+    stolen_pops += other.stolen_pops;
+    exclusive_pops += other.exclusive_pops;
+    local_work_hits += other.local_work_hits;
+    failed_locks += other.failed_locks;
+    parked_ns += other.parked_ns;
+    idle.spin_polls += other.idle.spin_polls;
+    idle.yield_polls += other.idle.yield_polls;
+    idle.spin_hits += other.idle.spin_hits;
+    idle.yield_hits += other.idle.yield_hits;
+    idle.parks += other.idle.parks;
+    return *this;
+  }
+};
+
+/**
+ * @brief Snapshot of all worker counters of a scheduler, see scheduler::collect_stats
+ */
+struct scheduler_stats
+{
+  // Indexed by worker
+  std::vector<worker_stats> workers;
+
+  /**
+   * @brief Sum of all workers
+   */
+  [[nodiscard]] auto get_total() const -> worker_stats
+  {
+    worker_stats total;
+    for (auto const& worker : workers)
+    {
+      total += worker;
+    }
+    return total;
+  }
+};
+
+} // namespace ouly
@@ -1,10 +1,30 @@
-
 #pragma once
 
 #include <atomic>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
 namespace ouly
 {
+
+/**
+ * @brief Hint the cpu that the current thread is busy waiting
+ */
+inline void cpu_pause() noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_pause();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+  __yield();
+#elif defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
 struct spin_lock
 {
   void lock() noexcept
@@ -34,4 +54,4 @@ private:
   std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
 };
 
-} // namespace ouly
\ No newline at end of file
+} // namespace ouly
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "ouly/scheduler/scheduler.hpp"
+#include <coroutine>
+
+namespace ouly
+{
+
+/**
+ * @brief Awaiter that resubmits the awaiting coroutine to a workgroup
+ */
+class switch_to_group_awaiter
+{
+public:
+  switch_to_group_awaiter(scheduler& s, workgroup_id group) noexcept : scheduler_(&s), group_(group) {}
+
+  [[nodiscard]] static auto await_ready() noexcept -> bool
+  {
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<> awaiting_coro) const noexcept
+  {
+    scheduler_->submit(worker_id::get(), group_,
+                       ouly::detail::work_item::pbind(
+                        [address = awaiting_coro.address()](worker_context const&)
+                        {
+                          std::coroutine_handle<>::from_address(address).resume();
+                        },
+                        group_));
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  scheduler*   scheduler_ = nullptr;
+  workgroup_id group_;
+};
+
+/**
+ * @brief Awaiter that resubmits the awaiting coroutine to a specific worker, continues inline when the coroutine is
+ * already running on that worker
+ */
+class switch_to_worker_awaiter
+{
+public:
+  switch_to_worker_awaiter(scheduler& s, worker_id worker, workgroup_id group) noexcept
+      : scheduler_(&s), worker_(worker), group_(group)
+  {}
+
+  [[nodiscard]] auto await_ready() const noexcept -> bool
+  {
+    return worker_id::get() == worker_;
+  }
+
+  void await_suspend(std::coroutine_handle<> awaiting_coro) const noexcept
+  {
+    scheduler_->submit(worker_id::get(), worker_,
+                       ouly::detail::work_item::pbind(
+                        [address = awaiting_coro.address()](worker_context const&)
+                        {
+                          std::coroutine_handle<>::from_address(address).resume();
+                        },
+                        group_));
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  scheduler*   scheduler_ = nullptr;
+  worker_id    worker_;
+  workgroup_id group_;
+};
+
+/**
+ * @brief Move the current coroutine to a workgroup, the rest of the coroutine is executed by a worker of that group.
+ *
+ * The suspended coroutine handle is pushed directly as a work item, no additional coroutine frame is allocated.
+ *
+ * @code
+ * ouly::co_task<void> stream(ouly::scheduler& s)
+ * {
+ *   co_await ouly::switch_to(s, io_group);
+ *   read_file();
+ *   co_await ouly::switch_to(s, ouly::default_workgroup_id);
+ *   process();
+ * }
+ * @endcode
+ *
+ * @note Must be awaited from a thread owned by the scheduler
+ */
+inline auto switch_to(scheduler& s, workgroup_id group) noexcept -> switch_to_group_awaiter
+{
+  return {s, group};
+}
+
+/**
+ * @brief Move the current coroutine to a specific worker, the coroutine resumes with the worker context of the given
+ * group on that worker.
+ *
+ * @note Must be awaited from a thread owned by the scheduler
+ */
+inline auto switch_to(scheduler& s, worker_id worker, workgroup_id group = default_workgroup_id) noexcept
+ -> switch_to_worker_awaiter
+{
+  return {s, worker, group};
+}
+
+} // namespace ouly
@@ -19,6 +19,15 @@ concept CoroutineTask = requires(T a) {
   { a.address() } -> std::same_as<void*>;
 };
 
+/**
+ * @brief A coroutine task that can complete without running when its cancellation_token is cancelled, a co_task
+ * returning void or a nothrow default constructible value
+ */
+template <typename T>
+concept CancellableTask = CoroutineTask<T> && requires(typename T::promise_type& p) {
+  { p.cancel() };
+};
+
 /**
  * @brief Use a coroutine task to defer execute a task, inital state is suspended. Coroutine is only resumed manually
  * and mostly by a scheduler. This task allows waiting on another task and be suspended during execution from any
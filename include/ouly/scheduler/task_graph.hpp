@@ -0,0 +1,122 @@
+#pragma once
+
+#include "ouly/scheduler/event_types.hpp"
+#include "ouly/scheduler/scheduler.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace ouly
+{
+
+/**
+ * @brief A reusable dependency graph of tasks executed on a scheduler
+ *
+ * Nodes wrap a task_delegate and the workgroup to run it on, edges are declared once between nodes. Once finalized the
+ * graph can be executed any number of times. Every node keeps an atomic predecessor counter, a completing node
+ * decrements the counters of its successors and submits the ones that become ready from the completing worker, so
+ * successors in a group the worker belongs to land in its own local queue. Executing a finalized graph does not
+ * allocate and takes no locks beyond the scheduler queues.
+ *
+ * Example usage:
+ * @code
+ * ouly::task_graph graph;
+ * auto load    = graph.add_node(ouly::default_workgroup_id, [](ouly::worker_context const&) {});
+ * auto animate = graph.add_node(ouly::default_workgroup_id, [](ouly::worker_context const&) {});
+ * auto render  = graph.add_node(render_group, [](ouly::worker_context const&) {});
+ * graph.add_edge(load, animate);
+ * graph.add_edge(animate, render);
+ * graph.finalize();
+ *
+ * // every frame
+ * graph.run(ouly::worker_context::get(ouly::default_workgroup_id));
+ * @endcode
+ *
+ * @note A graph can only be executed once at a time, and must not be modified while executing.
+ */
+class task_graph
+{
+public:
+  using node_id = uint32_t;
+
+  task_graph() noexcept                            = default;
+  task_graph(const task_graph&)                    = delete;
+  task_graph(task_graph&&)                         = delete;
+  auto operator=(const task_graph&) -> task_graph& = delete;
+  auto operator=(task_graph&&) -> task_graph&      = delete;
+  ~task_graph() noexcept                           = default;
+
+  /**
+   * @brief Add a node executing a lambda on the given workgroup
+   */
+  template <typename Lambda>
+    requires(ouly::detail::Callable<Lambda, ouly::worker_context const&>)
+  auto add_node(workgroup_id group, Lambda&& task) -> node_id
+  {
+    return add_node(group, task_delegate::bind(std::forward<Lambda>(task)));
+  }
+
+  /**
+   * @brief Add a node executing a task delegate on the given workgroup
+   */
+  OULY_API auto add_node(workgroup_id group, task_delegate task) -> node_id;
+
+  /**
+   * @brief Declare that node `after` can only start once node `before` has finished
+   */
+  OULY_API void add_edge(node_id before, node_id after);
+
+  /**
+   * @brief Build the successor lists, must be called after the last node or edge is added and before execution
+   * @return false if the edges form a cycle, the graph is then not finalized and cannot be executed
+   */
+  OULY_API auto finalize() -> bool;
+
+  /**
+   * @brief Submit the root nodes of the graph from the given worker, returns immediately
+   */
+  OULY_API void start(worker_context const& ctx) noexcept;
+
+  /**
+   * @brief Wait for a started graph to finish, the waiting worker executes other work meanwhile
+   */
+  OULY_API void wait(worker_context const& ctx);
+
+  /**
+   * @brief Execute the graph and wait for it to finish
+   */
+  void run(worker_context const& ctx)
+  {
+    start(ctx);
+    wait(ctx);
+  }
+
+  [[nodiscard]] auto get_node_count() const noexcept -> uint32_t
+  {
+    return static_cast<uint32_t>(nodes_.size());
+  }
+
+private:
+  struct node
+  {
+    task_delegate task_;
+    workgroup_id  group_;
+    uint32_t      predecessor_count_ = 0;
+    uint32_t      first_successor_   = 0;
+    uint32_t      successor_count_   = 0;
+  };
+
+  void submit_node(worker_context const& ctx, node_id id) noexcept;
+  void execute_node(worker_context const& ctx, node_id id) noexcept;
+
+  std::vector<node>                        nodes_;
+  std::vector<std::pair<node_id, node_id>> edges_;
+  std::vector<node_id>                     successors_;
+  std::vector<node_id>                     roots_;
+  std::unique_ptr<std::atomic_uint32_t[]>  pending_;
+  std::atomic_uint32_t                     remaining_ = 0;
+  busywork_event                           done_;
+  bool                                     finalized_ = false;
+};
+
+} // namespace ouly
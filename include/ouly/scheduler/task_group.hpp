@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ouly/scheduler/scheduler.hpp"
+#include "ouly/scheduler/spin_lock.hpp"
+#include <atomic>
+#include <vector>
+
+namespace ouly
+{
+
+namespace detail
+{
+/**
+ * @brief Children of a task_group, shared with the runner items submitted for them.
+ *
+ * A runner can still be queued after the group it was submitted for has been waited on and destroyed, when the waiter
+ * executed its child itself. The state is reference counted by the group and by every runner, and recycled through a
+ * per thread free list once the last reference is gone.
+ */
+struct task_group_state
+{
+  ouly::spin_lock            lock_;
+  std::vector<task_delegate> tasks_;
+  std::atomic_uint32_t       pending_    = 0;
+  std::atomic_uint32_t       references_ = 1;
+  task_group_state*          next_free_  = nullptr;
+};
+
+OULY_API auto acquire_task_group_state() -> task_group_state*;
+OULY_API void release_task_group_state(task_group_state* state) noexcept;
+} // namespace detail
+
+/**
+ * @brief A set of child tasks that can be waited on, for nested fork/join.
+ *
+ * run() records the task in the group and submits a runner to the group's workgroup, that runner executes whichever
+ * child of the group is still pending when it is dequeued. wait() executes the group's own pending children on the
+ * waiting worker first, then any other work the worker can find, and parks once all children are running elsewhere,
+ * so waiting neither blocks a worker on its own children nor oversubscribes the machine. Groups nest freely, a child
+ * can open and wait on its own task_group.
+ *
+ * @code
+ * void sum_tree(ouly::worker_context const& ctx, node* n)
+ * {
+ *   ouly::task_group children(ctx.get_workgroup());
+ *   for (auto* child : n->children_)
+ *     children.run(ctx, [child](ouly::worker_context const& wc) { sum_tree(wc, child); });
+ *   children.wait(ctx);
+ *   n->total_ = n->value_ + accumulate(n->children_);
+ * }
+ * @endcode
+ *
+ * @note wait must be called before the group is destroyed. A parked waiter does not pick up new work until the
+ * children of its group have finished.
+ */
+class task_group
+{
+public:
+  explicit task_group(workgroup_id group = default_workgroup_id)
+      : state_(ouly::detail::acquire_task_group_state()), group_(group)
+  {}
+  task_group(const task_group&)                    = delete;
+  task_group(task_group&&)                         = delete;
+  auto operator=(const task_group&) -> task_group& = delete;
+  auto operator=(task_group&&) -> task_group&      = delete;
+  OULY_API ~task_group() noexcept;
+
+  /**
+   * @brief Run a lambda as a child of the group
+   */
+  template <typename Lambda>
+    requires(ouly::detail::Callable<Lambda, ouly::worker_context const&>)
+  void run(worker_context const& ctx, Lambda&& task)
+  {
+    run(ctx, task_delegate::bind(std::forward<Lambda>(task)));
+  }
+
+  /**
+   * @brief Run a task delegate as a child of the group, submitted from the worker of ctx
+   */
+  OULY_API void run(worker_context const& ctx, task_delegate task);
+
+  /**
+   * @brief Wait for every child run so far, the waiting worker executes the group's children first, then other work,
+   * and parks when there is nothing left it can do
+   */
+  OULY_API void wait(worker_context const& ctx);
+
+  [[nodiscard]] auto get_workgroup() const noexcept -> workgroup_id
+  {
+    return group_;
+  }
+
+private:
+  ouly::detail::task_group_state* state_ = nullptr;
+  workgroup_id                    group_;
+};
+
+} // namespace ouly
@@ -19,5 +19,12 @@ struct default_task_traits
    * for the tasks.
    */
   static constexpr uint32_t fixed_batch_size = 0;
+  /**
+   * Relevant for ranged executers, if set to true the range is not split into batches up front. Instead every task
+   * works through its range in steps of one batch, and splits off the upper half of what is left into a new task only
+   * when the previously split off work has been taken by another worker (lazy binary splitting). Useful when the cost
+   * per element is uneven.
+   */
+  static constexpr bool adaptive_splitting = false;
 };
 } // namespace ouly
\ No newline at end of file
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "ouly/utility/config.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <span>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Scheduler tracing is compiled in only when OULY_SCHEDULER_TRACE is defined (cmake option
+ * OULY_SCHEDULER_TRACE). Otherwise OULY_TRACE_EVENT expands to nothing and workers carry no trace buffer.
+ */
+#ifdef OULY_SCHEDULER_TRACE
+#define OULY_TRACE_EVENT(ring, type, group) (ring).record(type, group)
+#else
+#define OULY_TRACE_EVENT(ring, type, group) ((void)0)
+#endif
+
+namespace ouly
+{
+
+enum class trace_event_type : uint8_t
+{
+  // A worker started executing a work item of group_
+  task_begin,
+  // A worker finished executing a work item of group_
+  task_end,
+  // A worker submitted a work item to group_
+  submit,
+  // A worker stole a work item of group_ from another worker's queue
+  steal,
+  // A worker went to sleep on its wake event
+  park,
+  // A worker woke up from its wake event
+  unpark,
+};
+
+/**
+ * @brief A single drained scheduler event
+ */
+struct trace_event
+{
+  static constexpr uint32_t no_group = 0xFF;
+
+  // Nanoseconds since begin_execution
+  uint64_t         timestamp_ = 0;
+  uint32_t         worker_    = 0;
+  uint32_t         group_     = no_group;
+  trace_event_type type_      = trace_event_type::task_begin;
+};
+
+/**
+ * @brief Write events in Chrome trace_event JSON format, the output can be loaded in chrome://tracing or Perfetto.
+ *
+ * Tasks and parks become duration events on one track per worker, submits and steals become instant events.
+ */
+OULY_API void write_chrome_trace(std::ostream& out, std::span<trace_event const> events);
+
+namespace detail
+{
+
+/**
+ * @brief Raw cpu timestamp counter, falls back to steady_clock nanoseconds where no counter is available
+ */
+inline auto read_trace_clock() noexcept -> uint64_t
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  return __rdtsc();
+#elif defined(__i386__) || defined(__x86_64__)
+  return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+  uint64_t value = 0;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+  return value;
+#else
+  return static_cast<uint64_t>(
+   std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * @brief Pairs a trace clock reading with a steady_clock reading, two samples give the clock frequency
+ */
+struct trace_clock_sample
+{
+  uint64_t ticks_ = 0;
+  int64_t  nanos_ = 0;
+
+  static auto now() noexcept -> trace_clock_sample
+  {
+    return {.ticks_ = read_trace_clock(),
+            .nanos_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count()};
+  }
+};
+
+/**
+ * @brief Fixed size event ring of a worker, only the owning worker records, a single reader drains.
+ *
+ * Events are packed into two atomic words so a reader racing a writer never reads a torn value. When the ring is full
+ * the oldest events are overwritten, the reader detects slots that were overwritten while it copied them and drops
+ * them.
+ */
+class trace_ring
+{
+public:
+  void reset(uint32_t capacity)
+  {
+    capacity = std::bit_ceil(std::max(capacity, 2U));
+    words_   = std::make_unique<std::atomic_uint64_t[]>(static_cast<std::size_t>(capacity) * 2);
+    mask_    = capacity - 1;
+    head_.store(0, std::memory_order_relaxed);
+    read_ = 0;
+  }
+
+  void record(trace_event_type type, uint32_t group) noexcept
+  {
+    auto  head = head_.load(std::memory_order_relaxed);
+    auto* slot = words_.get() + (static_cast<std::size_t>(head & mask_) * 2);
+    slot[0].store(read_trace_clock(), std::memory_order_relaxed);
+    slot[1].store((static_cast<uint64_t>(type) << 32U) | group, std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Append events recorded since the last drain, oldest first
+   */
+  void drain(std::vector<trace_event>& out, uint32_t worker, trace_clock_sample origin, double nanos_per_tick)
+  {
+    if (!words_)
+    {
+      return;
+    }
+    auto capacity = static_cast<uint64_t>(mask_) + 1;
+    auto head     = head_.load(std::memory_order_acquire);
+    auto first    = std::max(read_, head > capacity ? head - capacity : 0);
+    auto start    = out.size();
+    for (auto i = first; i != head; ++i)
+    {
+      auto const* slot  = words_.get() + (static_cast<std::size_t>(i & mask_) * 2);
+      auto        ticks = slot[0].load(std::memory_order_relaxed);
+      auto        word  = slot[1].load(std::memory_order_relaxed);
+      auto        delta = static_cast<double>(static_cast<int64_t>(ticks - origin.ticks_)) * nanos_per_tick;
+      out.push_back({.timestamp_ = delta > 0 ? static_cast<uint64_t>(delta) : 0,
+                     .worker_    = worker,
+                     .group_     = static_cast<uint32_t>(word),
+                     .type_      = static_cast<trace_event_type>(word >> 32U)});
+    }
+
+    // Slots the writer lapped while they were being copied hold newer events, drop them
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto now   = head_.load(std::memory_order_relaxed);
+    auto valid = now > capacity ? now - capacity : 0;
+    auto torn  = valid > first ? std::min(valid, head) - first : 0;
+    out.erase(out.begin() + static_cast<std::ptrdiff_t>(start),
+              out.begin() + static_cast<std::ptrdiff_t>(start + torn));
+    read_ = head;
+  }
+
+private:
+  std::unique_ptr<std::atomic_uint64_t[]> words_;
+  uint64_t                                mask_ = 0;
+  alignas(ouly::cache_line_size) std::atomic_uint64_t head_ = 0;
+  // Reader side
+  alignas(ouly::cache_line_size) uint64_t read_ = 0;
+};
+
+} // namespace detail
+} // namespace ouly
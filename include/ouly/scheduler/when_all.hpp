@@ -0,0 +1,340 @@
+#pragma once
+
+#include "ouly/scheduler/scheduler.hpp"
+#include "ouly/scheduler/spin_lock.hpp"
+#include <array>
+#include <coroutine>
+#include <span>
+#include <type_traits>
+
+namespace ouly::detail
+{
+
+/**
+ * @brief Coroutine task types that can be joined, co_task and co_sequence
+ */
+template <typename T>
+concept JoinableTask = CoroutineTask<T> && requires { typename T::promise_type; };
+
+/**
+ * @brief Lazy tasks are suspended on creation and must be submitted to start, co_sequence starts eagerly
+ */
+template <typename Task>
+constexpr bool is_lazy_task_v = std::is_same_v<
+ decltype(std::declval<typename Task::promise_type&>().initial_suspend()), std::suspend_always>;
+
+struct join_child
+{
+  coro_state* state_   = nullptr;
+  void*       address_ = nullptr;
+  bool        lazy_    = false;
+};
+
+template <JoinableTask Task>
+auto make_join_child(Task& task) noexcept -> join_child
+{
+  auto handle = std::coroutine_handle<typename Task::promise_type>::from_address(task.address());
+  return {&handle.promise(), task.address(), is_lazy_task_v<Task>};
+}
+
+/**
+ * @brief View over a span of tasks, yields join children on access
+ */
+template <JoinableTask Task>
+struct join_span
+{
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return tasks_.size();
+  }
+
+  auto operator[](std::size_t i) const noexcept -> join_child
+  {
+    return make_join_child(tasks_[i]);
+  }
+
+  std::span<Task> tasks_;
+};
+
+inline void submit_join_child(scheduler& s, workgroup_id group, void* address) noexcept
+{
+  s.submit(worker_id::get(), group,
+           work_item::pbind(
+            [address](worker_context const&)
+            {
+              std::coroutine_handle<>::from_address(address).resume();
+            },
+            group));
+}
+
+/**
+ * @brief Registers the join with a child, returns false if the child has already completed
+ */
+inline auto attach_join(join_child const& child, coro_join& join) noexcept -> bool
+{
+  coro_join* expected = nullptr;
+  return child.state_->join_.compare_exchange_strong(expected, &join, std::memory_order_acq_rel,
+                                                     std::memory_order_acquire);
+}
+
+struct when_all_join : coro_join
+{
+  when_all_join() noexcept : coro_join{&arrive} {}
+
+  static void arrive(coro_join& join, coro_state& /*child*/) noexcept
+  {
+    auto& self = static_cast<when_all_join&>(join);
+    // The join is gone once the last child arrives, read the continuation before counting down
+    auto continuation = self.continuation_;
+    if (self.pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      continuation.resume();
+    }
+  }
+
+  std::coroutine_handle<> continuation_ = nullptr;
+  std::atomic_uint32_t    pending_      = 0;
+};
+
+struct when_any_join : coro_join
+{
+  when_any_join() noexcept : coro_join{&arrive} {}
+
+  static void arrive(coro_join& join, coro_state& child) noexcept
+  {
+    auto&       self         = static_cast<when_any_join&>(join);
+    auto        continuation = self.continuation_;
+    coro_state* expected     = nullptr;
+    bool        resume       = self.winner_.compare_exchange_strong(expected, &child, std::memory_order_acq_rel) &&
+                  self.gate_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    self.references_.fetch_sub(1, std::memory_order_release);
+    if (resume)
+    {
+      continuation.resume();
+    }
+  }
+
+  std::coroutine_handle<> continuation_ = nullptr;
+  std::atomic<coro_state*> winner_      = nullptr;
+  // Opened by the first arrival and the end of await_suspend, whichever comes last resumes the parent
+  std::atomic_uint32_t gate_ = 0;
+  // Children that may still touch the join, plus one for the parent
+  std::atomic_uint32_t references_ = 0;
+};
+
+template <typename Children>
+class when_all_awaiter
+{
+public:
+  when_all_awaiter(Children children, workgroup_id group) noexcept : children_(children), group_(group) {}
+
+  [[nodiscard]] auto await_ready() const noexcept -> bool
+  {
+    return children_.size() == 0;
+  }
+
+  auto await_suspend(std::coroutine_handle<> awaiting_coro) noexcept -> bool
+  {
+    auto count          = static_cast<uint32_t>(children_.size());
+    join_.continuation_ = awaiting_coro;
+    // One extra arrival for this call, so children finishing early cannot resume the parent while it is submitting
+    join_.pending_.store(count + 1, std::memory_order_relaxed);
+
+    auto& sched = worker_context::get(group_).get_scheduler();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      join_child child = children_[i];
+      if (!attach_join(child, join_))
+      {
+        join_.pending_.fetch_sub(1, std::memory_order_acq_rel);
+      }
+      else if (child.lazy_)
+      {
+        submit_join_child(sched, group_, child.address_);
+      }
+    }
+    return join_.pending_.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  Children      children_;
+  workgroup_id  group_;
+  when_all_join join_;
+};
+
+template <typename Children>
+class when_any_awaiter
+{
+public:
+  when_any_awaiter(Children children, workgroup_id group) noexcept : children_(children), group_(group) {}
+
+  [[nodiscard]] auto await_ready() const noexcept -> bool
+  {
+    return children_.size() == 0;
+  }
+
+  auto await_suspend(std::coroutine_handle<> awaiting_coro) noexcept -> bool
+  {
+    auto count          = static_cast<uint32_t>(children_.size());
+    join_.continuation_ = awaiting_coro;
+    join_.gate_.store(2, std::memory_order_relaxed);
+    join_.references_.store(count + 1, std::memory_order_relaxed);
+
+    auto& sched = worker_context::get(group_).get_scheduler();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      join_child child = children_[i];
+      if (!attach_join(child, join_))
+      {
+        // Already complete, arrive on behalf of the child, the gate is still held so this cannot resume the parent
+        when_any_join::arrive(join_, *child.state_);
+      }
+      else if (child.lazy_)
+      {
+        submit_join_child(sched, group_, child.address_);
+      }
+    }
+    return join_.gate_.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+
+  /**
+   * @brief Returns the index of the first child to complete
+   */
+  auto await_resume() noexcept -> uint32_t
+  {
+    auto count = static_cast<uint32_t>(children_.size());
+    if (count == 0)
+    {
+      return 0;
+    }
+
+    // Detach the children still running, they complete silently and can be awaited again later
+    uint32_t winner = count;
+    auto*    first  = join_.winner_.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      join_child  child    = children_[i];
+      coro_join*  expected = &join_;
+      if (child.state_->join_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel,
+                                                      std::memory_order_acquire))
+      {
+        join_.references_.fetch_sub(1, std::memory_order_relaxed);
+      }
+      if (child.state_ == first)
+      {
+        winner = i;
+      }
+    }
+
+    // Children that completed concurrently only hold the join for a few instructions
+    if (join_.references_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+      while (join_.references_.load(std::memory_order_acquire) != 0)
+      {
+        ouly::cpu_pause();
+      }
+    }
+    return winner;
+  }
+
+private:
+  Children      children_;
+  workgroup_id  group_;
+  when_any_join join_;
+};
+
+} // namespace ouly::detail
+
+namespace ouly
+{
+
+/**
+ * @brief Await a set of coroutine tasks, the awaiting coroutine resumes once every task has completed.
+ *
+ * co_task children are submitted to the scheduler, co_sequence children are already running and are only joined. The
+ * parent is resumed exactly once, by whichever child completes last, no thread blocks while waiting. Results are read
+ * from the tasks once the join completes.
+ *
+ * @code
+ * ouly::co_task<void> parent()
+ * {
+ *   auto a = load(0);
+ *   auto b = load(1);
+ *   co_await ouly::when_all(a, b);
+ *   use(a.result(), b.result());
+ * }
+ * @endcode
+ *
+ * @note Must be awaited from a thread owned by the scheduler. co_task children must not have been started, and must
+ * outlive the join.
+ */
+template <ouly::detail::JoinableTask... Tasks>
+  requires(sizeof...(Tasks) > 0)
+auto when_all(workgroup_id group, Tasks&... tasks) noexcept
+ -> ouly::detail::when_all_awaiter<std::array<ouly::detail::join_child, sizeof...(Tasks)>>
+{
+  return {{ouly::detail::make_join_child(tasks)...}, group};
+}
+
+/**
+ * @brief Await a set of coroutine tasks, co_task children are submitted to the default workgroup
+ */
+template <ouly::detail::JoinableTask... Tasks>
+  requires(sizeof...(Tasks) > 0)
+auto when_all(Tasks&... tasks) noexcept
+ -> ouly::detail::when_all_awaiter<std::array<ouly::detail::join_child, sizeof...(Tasks)>>
+{
+  return {{ouly::detail::make_join_child(tasks)...}, default_workgroup_id};
+}
+
+/**
+ * @brief Await a range of coroutine tasks, the awaiting coroutine resumes once every task has completed
+ */
+template <ouly::detail::JoinableTask Task>
+auto when_all(std::span<Task> tasks, workgroup_id group = default_workgroup_id) noexcept
+ -> ouly::detail::when_all_awaiter<ouly::detail::join_span<Task>>
+{
+  return {{tasks}, group};
+}
+
+/**
+ * @brief Await the first of a set of coroutine tasks to complete, the co_await expression returns its index.
+ *
+ * All co_task children are submitted to the scheduler. The remaining children keep running after the parent resumes,
+ * they are detached from the join and can be awaited again individually, but must still outlive their execution.
+ *
+ * @note Must be awaited from a thread owned by the scheduler. co_task children must not have been started.
+ */
+template <ouly::detail::JoinableTask... Tasks>
+  requires(sizeof...(Tasks) > 0)
+auto when_any(workgroup_id group, Tasks&... tasks) noexcept
+ -> ouly::detail::when_any_awaiter<std::array<ouly::detail::join_child, sizeof...(Tasks)>>
+{
+  return {{ouly::detail::make_join_child(tasks)...}, group};
+}
+
+/**
+ * @brief Await the first of a set of coroutine tasks to complete, co_task children are submitted to the default
+ * workgroup
+ */
+template <ouly::detail::JoinableTask... Tasks>
+  requires(sizeof...(Tasks) > 0)
+auto when_any(Tasks&... tasks) noexcept
+ -> ouly::detail::when_any_awaiter<std::array<ouly::detail::join_child, sizeof...(Tasks)>>
+{
+  return {{ouly::detail::make_join_child(tasks)...}, default_workgroup_id};
+}
+
+/**
+ * @brief Await the first of a range of coroutine tasks to complete, the co_await expression returns its index
+ */
+template <ouly::detail::JoinableTask Task>
+auto when_any(std::span<Task> tasks, workgroup_id group = default_workgroup_id) noexcept
+ -> ouly::detail::when_any_awaiter<ouly::detail::join_span<Task>>
+{
+  return {{tasks}, group};
+}
+
+} // namespace ouly
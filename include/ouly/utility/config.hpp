@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 
 #if !defined(NDEBUG) || defined(_DEBUG)
@@ -14,6 +15,11 @@ inline static constexpr bool debug = true;
 #else
 inline static constexpr bool debug = false;
 #endif
+
+/**
+ * @brief Assumed size of a cache line, used to keep concurrently written data apart.
+ */
+inline static constexpr std::size_t cache_line_size = 64;
 } // namespace ouly
 
 #ifdef _MSC_VER
@@ -19,12 +19,27 @@
 #include "ouly/ecs/registry.hpp"
 #include "ouly/reflection/reflection.hpp"
 #include "ouly/reflection/type_name.hpp"
+#include "ouly/scheduler/async_sync.hpp"
 #include "ouly/scheduler/awaiters.hpp"
+#include "ouly/scheduler/cancellation.hpp"
+#include "ouly/scheduler/cpu_topology.hpp"
 #include "ouly/scheduler/event_types.hpp"
+#include "ouly/scheduler/io_service.hpp"
 #include "ouly/scheduler/parallel_for.hpp"
+#include "ouly/scheduler/parallel_reduce.hpp"
+#include "ouly/scheduler/parallel_scan.hpp"
+#include "ouly/scheduler/parallel_sort.hpp"
+#include "ouly/scheduler/pipeline.hpp"
 #include "ouly/scheduler/scheduler.hpp"
+#include "ouly/scheduler/scheduler_options.hpp"
+#include "ouly/scheduler/scheduler_stats.hpp"
 #include "ouly/scheduler/spin_lock.hpp"
+#include "ouly/scheduler/switch_to.hpp"
 #include "ouly/scheduler/task.hpp"
+#include "ouly/scheduler/task_graph.hpp"
+#include "ouly/scheduler/task_group.hpp"
+#include "ouly/scheduler/trace.hpp"
+#include "ouly/scheduler/when_all.hpp"
 #include "ouly/scheduler/worker_context.hpp"
 #include "ouly/serializers/lite_yml.hpp"
 #include "ouly/serializers/serializers.hpp"
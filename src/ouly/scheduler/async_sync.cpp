@@ -0,0 +1,265 @@
+#include "ouly/scheduler/async_sync.hpp"
+#include <cassert>
+#include <mutex>
+
+namespace ouly
+{
+
+namespace detail
+{
+void resume_waiters(scheduler& s, async_waiter* waiters) noexcept
+{
+  while (waiters != nullptr)
+  {
+    // The waiter lives in the coroutine frame, it is gone once the coroutine resumes
+    auto* next    = waiters->next_;
+    auto* address = waiters->coroutine_;
+    auto  group   = waiters->group_;
+    s.submit_any(group, ouly::detail::work_item::pbind(
+                         [address](worker_context const&)
+                         {
+                           std::coroutine_handle<>::from_address(address).resume();
+                         },
+                         group));
+    waiters = next;
+  }
+}
+} // namespace detail
+
+auto async_mutex::try_lock() noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  if (locked_)
+  {
+    return false;
+  }
+  locked_ = true;
+  return true;
+}
+
+auto async_mutex::enqueue(detail::async_waiter& waiter) noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  if (!locked_)
+  {
+    locked_ = true;
+    return false;
+  }
+  waiters_.push_back(waiter);
+  return true;
+}
+
+void async_mutex::unlock() noexcept
+{
+  detail::async_waiter* next = nullptr;
+  {
+    auto lck = std::scoped_lock(lock_);
+    assert(locked_ && "Unlocking an async_mutex that is not locked");
+    // Ownership passes to the first waiter, the mutex stays locked
+    next    = waiters_.pop_front();
+    locked_ = next != nullptr;
+  }
+  detail::resume_waiters(*scheduler_, next);
+}
+
+auto async_shared_mutex::acquire_locked(bool shared) noexcept -> bool
+{
+  if (shared)
+  {
+    // Queued writers go first
+    if (writer_ || !waiters_.empty())
+    {
+      return false;
+    }
+    ++readers_;
+    return true;
+  }
+  if (writer_ || readers_ != 0)
+  {
+    return false;
+  }
+  writer_ = true;
+  return true;
+}
+
+auto async_shared_mutex::try_lock() noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  return acquire_locked(false);
+}
+
+auto async_shared_mutex::try_lock_shared() noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  return acquire_locked(true);
+}
+
+auto async_shared_mutex::enqueue(detail::async_waiter& waiter) noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  if (acquire_locked(waiter.shared_))
+  {
+    return false;
+  }
+  waiters_.push_back(waiter);
+  return true;
+}
+
+void async_shared_mutex::unlock() noexcept
+{
+  detail::async_waiter* resumed = nullptr;
+  {
+    auto lck = std::scoped_lock(lock_);
+    assert(writer_ && "Unlocking an async_shared_mutex that is not locked");
+    writer_ = false;
+    auto* front = waiters_.front();
+    if (front != nullptr && !front->shared_)
+    {
+      writer_ = true;
+      resumed = waiters_.pop_front();
+    }
+    else
+    {
+      // Every shared waiter up to the next exclusive one
+      detail::async_waiter* last = nullptr;
+      while (waiters_.front() != nullptr && waiters_.front()->shared_)
+      {
+        auto* waiter = waiters_.pop_front();
+        (last != nullptr ? last->next_ : resumed) = waiter;
+        last                                      = waiter;
+        ++readers_;
+      }
+    }
+  }
+  detail::resume_waiters(*scheduler_, resumed);
+}
+
+void async_shared_mutex::unlock_shared() noexcept
+{
+  detail::async_waiter* resumed = nullptr;
+  {
+    auto lck = std::scoped_lock(lock_);
+    assert(readers_ != 0 && "Unlocking an async_shared_mutex that is not shared");
+    // Shared waiters only queue behind an exclusive one, the front waiter is exclusive
+    if (--readers_ == 0 && !waiters_.empty())
+    {
+      writer_ = true;
+      resumed = waiters_.pop_front();
+    }
+  }
+  detail::resume_waiters(*scheduler_, resumed);
+}
+
+auto async_semaphore::try_acquire() noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  if (count_ == 0)
+  {
+    return false;
+  }
+  --count_;
+  return true;
+}
+
+auto async_semaphore::enqueue(detail::async_waiter& waiter) noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  if (count_ != 0)
+  {
+    --count_;
+    return false;
+  }
+  waiters_.push_back(waiter);
+  return true;
+}
+
+void async_semaphore::release(uint32_t count) noexcept
+{
+  detail::async_waiter* resumed = nullptr;
+  {
+    auto                  lck  = std::scoped_lock(lock_);
+    detail::async_waiter* last = nullptr;
+    for (; count != 0 && !waiters_.empty(); --count)
+    {
+      auto* waiter = waiters_.pop_front();
+      (last != nullptr ? last->next_ : resumed) = waiter;
+      last                                      = waiter;
+    }
+    count_ += count;
+  }
+  detail::resume_waiters(*scheduler_, resumed);
+}
+
+auto async_semaphore::get_count() const noexcept -> uint32_t
+{
+  auto lck = std::scoped_lock(lock_);
+  return count_;
+}
+
+void async_latch::count_down(uint32_t n) noexcept
+{
+  detail::async_waiter* resumed = nullptr;
+  {
+    auto lck = std::scoped_lock(lock_);
+    assert(n <= count_ && "async_latch counted down below 0");
+    count_ -= n;
+    if (count_ == 0)
+    {
+      resumed = waiters_.take_all();
+    }
+  }
+  detail::resume_waiters(*scheduler_, resumed);
+}
+
+auto async_latch::try_wait() const noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  return count_ == 0;
+}
+
+auto async_latch::enqueue(detail::async_waiter& waiter) noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  if (count_ == 0)
+  {
+    return false;
+  }
+  waiters_.push_back(waiter);
+  return true;
+}
+
+void async_event::set() noexcept
+{
+  detail::async_waiter* resumed = nullptr;
+  {
+    auto lck = std::scoped_lock(lock_);
+    set_     = true;
+    resumed  = waiters_.take_all();
+  }
+  detail::resume_waiters(*scheduler_, resumed);
+}
+
+void async_event::reset() noexcept
+{
+  auto lck = std::scoped_lock(lock_);
+  set_     = false;
+}
+
+auto async_event::is_set() const noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  return set_;
+}
+
+auto async_event::enqueue(detail::async_waiter& waiter) noexcept -> bool
+{
+  auto lck = std::scoped_lock(lock_);
+  if (set_)
+  {
+    return false;
+  }
+  waiters_.push_back(waiter);
+  return true;
+}
+
+} // namespace ouly
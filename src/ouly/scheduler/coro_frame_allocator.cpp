@@ -0,0 +1,194 @@
+
+#include "ouly/scheduler/detail/coro_frame_allocator.hpp"
+#include "ouly/allocators/pool_allocator.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace ouly::detail
+{
+
+namespace
+{
+// Pooled frames are prefixed by a pointer to their owning pool, padded to keep the frame aligned
+constexpr std::size_t frame_header_size = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+constexpr uint32_t    min_frame_class   = std::bit_width(min_pooled_frame_size - 1);
+constexpr uint32_t    frame_class_count = std::bit_width(max_pooled_frame_size - 1) - min_frame_class + 1;
+constexpr std::size_t frames_per_arena  = 64;
+
+static_assert(sizeof(void*) <= frame_header_size);
+
+constexpr auto get_frame_class(std::size_t block_size) noexcept -> uint32_t
+{
+  auto width = static_cast<uint32_t>(std::bit_width(block_size - 1));
+  return width > min_frame_class ? width - min_frame_class : 0;
+}
+
+constexpr auto get_class_size(uint32_t frame_class) noexcept -> std::size_t
+{
+  return min_pooled_frame_size << frame_class;
+}
+
+struct frame_pool
+{
+  using allocator = ouly::pool_allocator<>;
+
+  frame_pool() noexcept
+      : pools_(
+         []<std::size_t... I>(std::index_sequence<I...>)
+         {
+           return std::array<allocator, frame_class_count>{allocator(get_class_size(I), frames_per_arena)...};
+         }(std::make_index_sequence<frame_class_count>()))
+  {}
+
+  auto allocate(uint32_t frame_class) -> void*
+  {
+    if (remote_frees_[frame_class].load(std::memory_order_relaxed) != nullptr)
+    {
+      reclaim(frame_class);
+    }
+    return pools_[frame_class].allocate(get_class_size(frame_class));
+  }
+
+  void deallocate(uint32_t frame_class, void* block) noexcept
+  {
+    pools_[frame_class].deallocate(block, get_class_size(frame_class));
+  }
+
+  void deallocate_remote(uint32_t frame_class, void* block) noexcept
+  {
+    auto& list = remote_frees_[frame_class];
+    auto* head = list.load(std::memory_order_relaxed);
+    do
+    {
+      *static_cast<void**>(block) = head;
+    }
+    while (!list.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  void reclaim(uint32_t frame_class) noexcept
+  {
+    void* block = remote_frees_[frame_class].exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr)
+    {
+      void* next = *static_cast<void**>(block);
+      deallocate(frame_class, block);
+      block = next;
+    }
+  }
+
+  std::array<allocator, frame_class_count>          pools_;
+  std::array<std::atomic<void*>, frame_class_count> remote_frees_{};
+};
+
+/**
+ * @brief Pools are never destroyed as frames may outlive their thread, pools of exited threads are reused
+ */
+struct frame_pool_registry
+{
+  auto acquire() -> frame_pool*
+  {
+    std::scoped_lock lock(lock_);
+    if (parked_.empty())
+    {
+      // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+      return new frame_pool();
+    }
+    auto* pool = parked_.back();
+    parked_.pop_back();
+    return pool;
+  }
+
+  void park(frame_pool* pool)
+  {
+    std::scoped_lock lock(lock_);
+    parked_.push_back(pool);
+  }
+
+  std::mutex               lock_;
+  std::vector<frame_pool*> parked_;
+};
+
+auto get_registry() -> frame_pool_registry&
+{
+  // Leaked on purpose, frames can still be released by static destructors
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  static auto* registry = new frame_pool_registry();
+  return *registry;
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+thread_local frame_pool* t_frame_pool = nullptr;
+
+struct frame_pool_owner
+{
+  frame_pool_owner() : pool_(get_registry().acquire())
+  {
+    t_frame_pool = pool_;
+  }
+
+  frame_pool_owner(frame_pool_owner const&)                    = delete;
+  frame_pool_owner(frame_pool_owner&&)                         = delete;
+  auto operator=(frame_pool_owner const&) -> frame_pool_owner& = delete;
+  auto operator=(frame_pool_owner&&) -> frame_pool_owner&      = delete;
+
+  ~frame_pool_owner() noexcept
+  {
+    t_frame_pool = nullptr;
+    get_registry().park(pool_);
+  }
+
+  frame_pool* pool_ = nullptr;
+};
+
+auto get_local_pool() -> frame_pool&
+{
+  if (t_frame_pool == nullptr) [[unlikely]]
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+    thread_local frame_pool_owner owner;
+  }
+  return *t_frame_pool;
+}
+} // namespace
+
+auto allocate_coro_frame(std::size_t size) -> void*
+{
+  auto block_size = size + frame_header_size;
+  if (block_size > max_pooled_frame_size)
+  {
+    return ::operator new(size);
+  }
+
+  auto& pool  = get_local_pool();
+  auto* block = static_cast<std::byte*>(pool.allocate(get_frame_class(block_size)));
+  *reinterpret_cast<frame_pool**>(block) = &pool; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  return block + frame_header_size;
+}
+
+void deallocate_coro_frame(void* frame, std::size_t size) noexcept
+{
+  auto block_size = size + frame_header_size;
+  if (block_size > max_pooled_frame_size)
+  {
+    ::operator delete(frame, size);
+    return;
+  }
+
+  auto* block = static_cast<std::byte*>(frame) - frame_header_size;
+  auto* owner = *reinterpret_cast<frame_pool**>(block); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  auto  frame_class = get_frame_class(block_size);
+  if (owner == t_frame_pool)
+  {
+    owner->deallocate(frame_class, block);
+  }
+  else
+  {
+    owner->deallocate_remote(frame_class, block);
+  }
+}
+
+} // namespace ouly::detail
@@ -0,0 +1,236 @@
+
+#include "ouly/scheduler/cpu_topology.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace ouly
+{
+
+namespace
+{
+constexpr uint32_t max_cache_index = 16;
+constexpr uint32_t l3_cache_level  = 3;
+
+auto read_file(std::string const& path) -> std::string
+{
+  std::ifstream file(path);
+  std::string   content;
+  std::getline(file, content);
+  return content;
+}
+
+auto parse_uint(std::string_view text, uint32_t fallback) noexcept -> uint32_t
+{
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+  {
+    text.remove_prefix(1);
+  }
+  uint32_t value = 0;
+  auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+  return ec == std::errc() ? value : fallback;
+}
+
+auto read_uint(std::string const& path, uint32_t fallback) -> uint32_t
+{
+  return parse_uint(read_file(path), fallback);
+}
+
+/**
+ * @brief Parse a sysfs cpu list, ie. "0-3,8,10-11"
+ */
+auto parse_cpu_list(std::string_view text) -> std::vector<uint32_t>
+{
+  std::vector<uint32_t> cpus;
+  while (!text.empty())
+  {
+    auto comma = text.find(',');
+    auto item  = text.substr(0, comma);
+    auto dash  = item.find('-');
+    auto first = parse_uint(item.substr(0, dash), cpu_info::invalid);
+    auto last  = dash == std::string_view::npos ? first : parse_uint(item.substr(dash + 1), cpu_info::invalid);
+    if (first != cpu_info::invalid && last != cpu_info::invalid)
+    {
+      for (uint32_t cpu = first; cpu <= last; ++cpu)
+      {
+        cpus.push_back(cpu);
+      }
+    }
+    text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+  }
+  return cpus;
+}
+
+auto get_l3_key(std::string const& cpu_path, uint32_t package) -> std::pair<uint32_t, uint32_t>
+{
+  for (uint32_t index = 0; index < max_cache_index; ++index)
+  {
+    auto cache_path = cpu_path + "/cache/index" + std::to_string(index);
+    auto level      = read_uint(cache_path + "/level", 0);
+    if (level == 0 && read_file(cache_path + "/type").empty())
+    {
+      break;
+    }
+    if (level == l3_cache_level)
+    {
+      auto shared = parse_cpu_list(read_file(cache_path + "/shared_cpu_list"));
+      if (!shared.empty())
+      {
+        return {0, *std::ranges::min_element(shared)};
+      }
+    }
+  }
+  // No cache information, assume the package shares its last level cache
+  return {1, package};
+}
+} // namespace
+
+cpu_topology::cpu_topology(std::vector<cpu_info> cpus) : cpus_(std::move(cpus))
+{
+  std::ranges::sort(cpus_,
+                    [](cpu_info const& a, cpu_info const& b)
+                    {
+                      return a.cpu_ < b.cpu_;
+                    });
+  for (auto const& cpu : cpus_)
+  {
+    node_count_ = std::max(node_count_, cpu.node_ + 1);
+    core_count_ = std::max(core_count_, cpu.core_ + 1);
+    l3_count_   = std::max(l3_count_, cpu.l3_ + 1);
+  }
+}
+
+auto cpu_topology::detect(std::string_view sysfs_root) -> cpu_topology
+{
+  std::string root(sysfs_root);
+  auto        online = parse_cpu_list(read_file(root + "/cpu/online"));
+
+  std::vector<cpu_info> cpus;
+  if (online.empty())
+  {
+    auto count = std::max(1U, std::thread::hardware_concurrency());
+    cpus.reserve(count);
+    for (uint32_t cpu = 0; cpu < count; ++cpu)
+    {
+      cpus.push_back(cpu_info{.cpu_ = cpu, .core_ = cpu, .package_ = 0, .node_ = 0, .l3_ = 0});
+    }
+    return cpu_topology(std::move(cpus));
+  }
+
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> cores;
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> l3s;
+  cpus.reserve(online.size());
+  for (auto cpu : online)
+  {
+    auto cpu_path = root + "/cpu/cpu" + std::to_string(cpu);
+    auto package  = read_uint(cpu_path + "/topology/physical_package_id", 0);
+    auto core_id  = read_uint(cpu_path + "/topology/core_id", cpu);
+
+    auto core = cores.try_emplace({package, core_id}, static_cast<uint32_t>(cores.size())).first->second;
+    auto l3   = l3s.try_emplace(get_l3_key(cpu_path, package), static_cast<uint32_t>(l3s.size())).first->second;
+    cpus.push_back(cpu_info{.cpu_ = cpu, .core_ = core, .package_ = package, .node_ = 0, .l3_ = l3});
+  }
+
+  for (auto node : parse_cpu_list(read_file(root + "/node/online")))
+  {
+    for (auto cpu : parse_cpu_list(read_file(root + "/node/node" + std::to_string(node) + "/cpulist")))
+    {
+      auto it = std::ranges::find(cpus, cpu, &cpu_info::cpu_);
+      if (it != cpus.end())
+      {
+        it->node_ = node;
+      }
+    }
+  }
+
+  return cpu_topology(std::move(cpus));
+}
+
+auto cpu_topology::pin_current_thread([[maybe_unused]] uint32_t cpu) noexcept -> bool
+{
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (cpu >= CPU_SETSIZE)
+  {
+    return false;
+  }
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+  CPU_SET(cpu, &set);
+#pragma GCC diagnostic pop
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+  constexpr uint32_t mask_bits = sizeof(DWORD_PTR) * 8;
+  if (cpu >= mask_bits)
+  {
+    return false;
+  }
+  return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << cpu) != 0;
+#else
+  return false;
+#endif
+}
+
+auto cpu_topology::find(uint32_t cpu) const noexcept -> cpu_info const*
+{
+  auto it = std::ranges::lower_bound(cpus_, cpu, {}, &cpu_info::cpu_);
+  return it != cpus_.end() && it->cpu_ == cpu ? &*it : nullptr;
+}
+
+auto cpu_topology::get_physical_cores(uint32_t node) const -> std::vector<uint32_t>
+{
+  std::vector<uint32_t> result;
+  std::vector<bool>     seen(core_count_, false);
+  for (auto const& cpu : cpus_)
+  {
+    if ((node == any_node || cpu.node_ == node) && !seen[cpu.core_])
+    {
+      seen[cpu.core_] = true;
+      result.push_back(cpu.cpu_);
+    }
+  }
+  return result;
+}
+
+auto cpu_topology::get_logical_cpus(uint32_t node) const -> std::vector<uint32_t>
+{
+  std::vector<cpu_info> selected;
+  std::ranges::copy_if(cpus_, std::back_inserter(selected),
+                       [node](cpu_info const& cpu)
+                       {
+                         return node == any_node || cpu.node_ == node;
+                       });
+  std::ranges::stable_sort(selected,
+                           [](cpu_info const& a, cpu_info const& b)
+                           {
+                             return a.core_ < b.core_;
+                           });
+  std::vector<uint32_t> result;
+  result.reserve(selected.size());
+  for (auto const& cpu : selected)
+  {
+    result.push_back(cpu.cpu_);
+  }
+  return result;
+}
+
+} // namespace ouly
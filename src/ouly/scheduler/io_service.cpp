@@ -0,0 +1,471 @@
+
+#include "ouly/scheduler/io_service.hpp"
+#include <cassert>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define OULY_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ouly::detail
+{
+
+class io_backend_impl
+{
+public:
+  io_backend_impl() noexcept                                 = default;
+  io_backend_impl(io_backend_impl const&)                    = delete;
+  io_backend_impl(io_backend_impl&&)                         = delete;
+  auto operator=(io_backend_impl const&) -> io_backend_impl& = delete;
+  auto operator=(io_backend_impl&&) -> io_backend_impl&      = delete;
+  virtual ~io_backend_impl() noexcept                        = default;
+
+  virtual void submit(io_request& request) noexcept = 0;
+};
+
+namespace
+{
+
+/**
+ * @brief Blocking positional read or write, returns the byte count or a negative errno
+ */
+auto run_request(io_request const& request) noexcept -> int64_t
+{
+#if defined(_WIN32)
+  auto*      handle = reinterpret_cast<HANDLE>(_get_osfhandle(request.fd_)); // NOLINT
+  OVERLAPPED overlapped{};
+  overlapped.Offset     = static_cast<DWORD>(request.offset_);
+  overlapped.OffsetHigh = static_cast<DWORD>(request.offset_ >> 32U);
+  DWORD size            = static_cast<DWORD>(std::min<std::size_t>(request.size_, MAXDWORD));
+  DWORD transferred     = 0;
+  BOOL  ok              = request.op_ == io_op::read
+                           ? ReadFile(handle, request.data_, size, &transferred, &overlapped)
+                           : WriteFile(handle, request.data_, size, &transferred, &overlapped);
+  if (!ok)
+  {
+    auto error = GetLastError();
+    return error == ERROR_HANDLE_EOF ? 0 : -EIO;
+  }
+  return static_cast<int64_t>(transferred);
+#else
+  while (true)
+  {
+    auto result = request.op_ == io_op::read
+                   ? ::pread(request.fd_, request.data_, request.size_, static_cast<off_t>(request.offset_))
+                   : ::pwrite(request.fd_, request.data_, request.size_, static_cast<off_t>(request.offset_));
+    if (result >= 0)
+    {
+      return static_cast<int64_t>(result);
+    }
+    if (errno != EINTR)
+    {
+      return -static_cast<int64_t>(errno);
+    }
+  }
+#endif
+}
+
+/**
+ * @brief Fallback backend, a few threads running blocking reads and writes
+ */
+class thread_pool_backend final : public io_backend_impl
+{
+public:
+  thread_pool_backend(io_service& service, uint32_t thread_count) : service_(&service)
+  {
+    threads_.reserve(std::max(thread_count, 1U));
+    for (uint32_t i = 0; i < std::max(thread_count, 1U); ++i)
+    {
+      threads_.emplace_back(&thread_pool_backend::run, this);
+    }
+  }
+
+  thread_pool_backend(thread_pool_backend const&)                    = delete;
+  thread_pool_backend(thread_pool_backend&&)                         = delete;
+  auto operator=(thread_pool_backend const&) -> thread_pool_backend& = delete;
+  auto operator=(thread_pool_backend&&) -> thread_pool_backend&      = delete;
+
+  ~thread_pool_backend() noexcept override
+  {
+    {
+      auto lck = std::scoped_lock(mutex_);
+      stop_    = true;
+    }
+    ready_.notify_all();
+    for (auto& thread : threads_)
+    {
+      thread.join();
+    }
+  }
+
+  void submit(io_request& request) noexcept override
+  {
+    // Notify under the lock, once it is released a pool thread can complete the request and the service can go away
+    auto lck = std::scoped_lock(mutex_);
+    pending_.push_back(&request);
+    ready_.notify_one();
+  }
+
+private:
+  void run() noexcept
+  {
+    while (true)
+    {
+      io_request* request = nullptr;
+      {
+        auto lck = std::unique_lock(mutex_);
+        ready_.wait(lck,
+                    [this]
+                    {
+                      return stop_ || !pending_.empty();
+                    });
+        if (pending_.empty())
+        {
+          return;
+        }
+        request = pending_.front();
+        pending_.pop_front();
+      }
+      service_->complete(*request, run_request(*request));
+    }
+  }
+
+  io_service*              service_ = nullptr;
+  std::mutex               mutex_;
+  std::condition_variable  ready_;
+  std::deque<io_request*>  pending_;
+  std::vector<std::thread> threads_;
+  bool                     stop_ = false;
+};
+
+#ifdef OULY_HAS_IO_URING
+
+/**
+ * @brief io_uring through raw system calls. Submissions are serialized by a lock and entered right away, one
+ * completion thread reaps the completion queue and resumes the coroutines.
+ */
+class io_uring_backend final : public io_backend_impl
+{
+  // user_data of the no-op that stops the completion thread
+  static constexpr uint64_t stop_token = 0;
+
+public:
+  explicit io_uring_backend(io_service& service) noexcept : service_(&service) {}
+
+  io_uring_backend(io_uring_backend const&)                    = delete;
+  io_uring_backend(io_uring_backend&&)                         = delete;
+  auto operator=(io_uring_backend const&) -> io_uring_backend& = delete;
+  auto operator=(io_uring_backend&&) -> io_uring_backend&      = delete;
+
+  ~io_uring_backend() noexcept override
+  {
+    if (completion_thread_.joinable())
+    {
+      {
+        auto lck = std::scoped_lock(submit_lock_);
+        // A ring that rejects the no-op fails the completion thread's wait as well, which then returns on its own
+        [[maybe_unused]] auto error = push(IORING_OP_NOP, -1, nullptr, 0, 0, stop_token);
+      }
+      completion_thread_.join();
+    }
+    if (sqes_ != nullptr)
+    {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+    {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr)
+    {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_fd_ >= 0)
+    {
+      close(ring_fd_);
+    }
+  }
+
+  /**
+   * @brief Create the ring, returns false if io_uring or its read and write operations are unavailable
+   */
+  auto init(uint32_t queue_depth) noexcept -> bool
+  {
+    io_uring_params params{};
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, std::max(queue_depth, 1U), &params));
+    if (ring_fd_ < 0 || !supports_read_write())
+    {
+      return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + (params.sq_entries * sizeof(uint32_t));
+    cq_ring_size_ = params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+    {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = (params.features & IORING_FEAT_SINGLE_MMAP) != 0 ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_      = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr)
+    {
+      return false;
+    }
+
+    sq_head_  = field(sq_ring_, params.sq_off.head);
+    sq_tail_  = field(sq_ring_, params.sq_off.tail);
+    sq_mask_  = *field(sq_ring_, params.sq_off.ring_mask);
+    sq_array_ = field(sq_ring_, params.sq_off.array);
+    cq_head_  = field(cq_ring_, params.cq_off.head);
+    cq_tail_  = field(cq_ring_, params.cq_off.tail);
+    cq_mask_  = *field(cq_ring_, params.cq_off.ring_mask);
+    cqes_     = static_cast<io_uring_cqe*>(static_cast<void*>(static_cast<std::byte*>(cq_ring_) + params.cq_off.cqes));
+    sq_size_  = params.sq_entries;
+
+    completion_thread_ = std::thread(&io_uring_backend::reap, this);
+    return true;
+  }
+
+  void submit(io_request& request) noexcept override
+  {
+    int error = 0;
+    {
+      auto lck = std::scoped_lock(submit_lock_);
+      error    = push(request.op_ == io_op::read ? IORING_OP_READ : IORING_OP_WRITE, request.fd_, request.data_,
+                      static_cast<uint32_t>(std::min<std::size_t>(request.size_, std::numeric_limits<uint32_t>::max())),
+                      request.offset_, reinterpret_cast<uint64_t>(&request)); // NOLINT
+    }
+    // The kernel never saw the request, no completion will arrive for it
+    if (error < 0)
+    {
+      service_->complete(request, error);
+    }
+  }
+
+private:
+  static auto field(void* ring, uint32_t offset) noexcept -> uint32_t*
+  {
+    return static_cast<uint32_t*>(static_cast<void*>(static_cast<std::byte*>(ring) + offset));
+  }
+
+  auto map(std::size_t size, off_t offset) const noexcept -> void*
+  {
+    auto* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr; // NOLINT
+  }
+
+  auto supports_read_write() const noexcept -> bool
+  {
+    constexpr uint32_t op_count = 256;
+    std::vector<std::byte> storage(sizeof(io_uring_probe) + (op_count * sizeof(io_uring_probe_op)));
+    auto* probe = static_cast<io_uring_probe*>(static_cast<void*>(storage.data()));
+    if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE, probe, op_count) < 0)
+    {
+      return false;
+    }
+    auto supported = [probe](uint32_t op)
+    {
+      return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    };
+    return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+  }
+
+  /**
+   * @brief Fill the next submission entry and enter it, called with submit_lock_ held. Returns 0, or a negative errno
+   * if the kernel rejected the entry, in which case it is taken back out of the submission queue.
+   */
+  auto push(uint8_t opcode, int fd, void* data, uint32_t size, uint64_t offset, uint64_t user_data) noexcept -> int
+  {
+    // Entries are consumed by every enter, the queue is never full when a new entry is pushed
+    auto tail = *sq_tail_;
+    assert(tail - std::atomic_ref(*sq_head_).load(std::memory_order_acquire) < sq_size_);
+    auto  index = tail & sq_mask_;
+    auto& sqe   = sqes_[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode    = opcode;
+    sqe.fd        = fd;
+    sqe.addr      = reinterpret_cast<uint64_t>(data); // NOLINT
+    sqe.len       = size;
+    sqe.off       = offset;
+    sqe.user_data = user_data;
+    sq_array_[index] = index;
+    std::atomic_ref(*sq_tail_).store(tail + 1, std::memory_order_release);
+
+    while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0)
+    {
+      // Busy when the completion queue overflowed, the completion thread is draining it
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+      {
+        // Enter only fails when it consumed nothing, a later enter would otherwise submit the stale entry
+        auto error = errno;
+        std::atomic_ref(*sq_tail_).store(tail, std::memory_order_release);
+        return -error;
+      }
+      std::this_thread::yield();
+    }
+    return 0;
+  }
+
+  void reap() noexcept
+  {
+    bool stop = false;
+    while (!stop)
+    {
+      if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR &&
+          errno != EAGAIN && errno != EBUSY)
+      {
+        return;
+      }
+
+      auto head = *cq_head_;
+      auto tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+      // The kernel passes requests on without a visible ordering, pair with the release of the submission tail so the
+      // request fields written before submit are ordered before complete
+      [[maybe_unused]] auto submitted = std::atomic_ref(*sq_tail_).load(std::memory_order_acquire);
+      for (; head != tail; ++head)
+      {
+        auto const& cqe = cqes_[head & cq_mask_];
+        if (cqe.user_data == stop_token)
+        {
+          stop = true;
+          continue;
+        }
+        service_->complete(*reinterpret_cast<io_request*>(cqe.user_data), cqe.res); // NOLINT
+      }
+      std::atomic_ref(*cq_head_).store(head, std::memory_order_release);
+    }
+  }
+
+  io_service*   service_ = nullptr;
+  std::mutex    submit_lock_;
+  std::thread   completion_thread_;
+  int           ring_fd_      = -1;
+  void*         sq_ring_      = nullptr;
+  void*         cq_ring_      = nullptr;
+  io_uring_sqe* sqes_         = nullptr;
+  io_uring_cqe* cqes_         = nullptr;
+  std::size_t   sq_ring_size_ = 0;
+  std::size_t   cq_ring_size_ = 0;
+  std::size_t   sqes_size_    = 0;
+  uint32_t*     sq_head_      = nullptr;
+  uint32_t*     sq_tail_      = nullptr;
+  uint32_t*     sq_array_     = nullptr;
+  uint32_t*     cq_head_      = nullptr;
+  uint32_t*     cq_tail_      = nullptr;
+  uint32_t      sq_mask_      = 0;
+  uint32_t      cq_mask_      = 0;
+  uint32_t      sq_size_      = 0;
+};
+
+#endif
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<io_service*> g_default_io_service = nullptr;
+
+} // namespace
+} // namespace ouly::detail
+
+namespace ouly
+{
+
+io_service::io_service(scheduler& owner, io_service_options const& options) : scheduler_(&owner)
+{
+#ifdef OULY_HAS_IO_URING
+  if (options.backend != io_backend::thread_pool)
+  {
+    auto ring = std::make_unique<ouly::detail::io_uring_backend>(*this);
+    if (ring->init(options.queue_depth))
+    {
+      impl_    = std::move(ring);
+      backend_ = io_backend::io_uring;
+    }
+  }
+#endif
+  if (!impl_)
+  {
+    impl_    = std::make_unique<ouly::detail::thread_pool_backend>(*this, options.fallback_threads);
+    backend_ = io_backend::thread_pool;
+  }
+
+  io_service* expected = nullptr;
+  ouly::detail::g_default_io_service.compare_exchange_strong(expected, this);
+}
+
+io_service::~io_service() noexcept
+{
+  for (auto pending = in_flight_.load(); pending != 0; pending = in_flight_.load())
+  {
+    in_flight_.wait(pending);
+  }
+  impl_.reset();
+
+  io_service* expected = this;
+  ouly::detail::g_default_io_service.compare_exchange_strong(expected, nullptr);
+}
+
+auto io_service::get_default() noexcept -> io_service&
+{
+  auto* service = ouly::detail::g_default_io_service.load(std::memory_order_acquire);
+  assert(service && "No io_service was created");
+  return *service;
+}
+
+void io_service::make_default() noexcept
+{
+  ouly::detail::g_default_io_service.store(this, std::memory_order_release);
+}
+
+void io_service::submit(ouly::detail::io_request& request) noexcept
+{
+  // One count for the request and one for this call, the backend is not destroyed before its submit has returned
+  in_flight_.fetch_add(2, std::memory_order_relaxed);
+  // The request can be resumed and destroyed by the time this returns
+  impl_->submit(request);
+  if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    in_flight_.notify_all();
+  }
+}
+
+void io_service::complete(ouly::detail::io_request& request, int64_t result) noexcept
+{
+  request.result_ = result;
+  auto group      = request.group_;
+  // A failed submission completes on the worker that submitted it
+  scheduler_->submit_any(group, ouly::detail::work_item::pbind(
+                                 [address = request.coroutine_](worker_context const&)
+                                 {
+                                   std::coroutine_handle<>::from_address(address).resume();
+                                 },
+                                 group));
+  if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    in_flight_.notify_all();
+  }
+}
+
+} // namespace ouly
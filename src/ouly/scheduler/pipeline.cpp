@@ -0,0 +1,225 @@
+#include "ouly/scheduler/pipeline.hpp"
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+
+namespace ouly
+{
+
+pipeline::pipeline(uint32_t max_tokens)
+    : sequences_(std::make_unique<uint32_t[]>(max_tokens)), free_tokens_(std::make_unique<uint32_t[]>(max_tokens)),
+      max_tokens_(max_tokens)
+{
+  assert(max_tokens > 0 && "A pipeline needs at least one token");
+}
+
+void pipeline::set_input(workgroup_id group, input_delegate input)
+{
+  input_       = std::move(input);
+  input_group_ = group;
+}
+
+void pipeline::add_stage(stage_mode mode, workgroup_id group, stage_delegate stage_fn)
+{
+  auto s    = std::make_unique<stage>();
+  s->fn_    = std::move(stage_fn);
+  s->group_ = group;
+  s->mode_  = mode;
+  if (mode != stage_mode::parallel)
+  {
+    s->waiting_ = std::make_unique<uint32_t[]>(max_tokens_);
+  }
+  stages_.emplace_back(std::move(s));
+}
+
+void pipeline::start(worker_context const& ctx) noexcept
+{
+  for (auto& s : stages_)
+  {
+    s->next_sequence_ = 0;
+    s->head_          = 0;
+    s->tail_          = 0;
+    s->busy_          = false;
+    if (s->mode_ == stage_mode::serial_in_order)
+    {
+      std::fill_n(s->waiting_.get(), max_tokens_, no_token);
+    }
+  }
+
+  for (uint32_t i = 0; i < max_tokens_; ++i)
+  {
+    // Handed out from the back, the first item gets token 0
+    free_tokens_[i] = max_tokens_ - i - 1;
+  }
+  free_count_   = max_tokens_;
+  in_flight_    = 0;
+  next_input_   = 0;
+  input_active_ = true;
+  input_done_   = false;
+
+  submit_input(ctx);
+}
+
+void pipeline::wait(worker_context const& ctx)
+{
+  done_.wait(ctx.get_worker(), ctx.get_scheduler());
+}
+
+void pipeline::submit_input(worker_context const& ctx) noexcept
+{
+  ctx.get_scheduler().submit(ctx.get_worker(), input_group_,
+                             ouly::detail::work_item::pbind(
+                              [this](worker_context const& wc)
+                              {
+                                run_input(wc);
+                              },
+                              input_group_));
+}
+
+void pipeline::run_input(worker_context const& ctx) noexcept
+{
+  while (true)
+  {
+    uint32_t token = no_token;
+    {
+      std::scoped_lock lock(lock_);
+      if (free_count_ == 0)
+      {
+        // The token released next starts the input again
+        input_active_ = false;
+        return;
+      }
+      token = free_tokens_[--free_count_];
+      ++in_flight_;
+    }
+
+    if (!input_(token, ctx))
+    {
+      bool finished = false;
+      {
+        std::scoped_lock lock(lock_);
+        free_tokens_[free_count_++] = token;
+        --in_flight_;
+        input_done_   = true;
+        input_active_ = false;
+        finished      = in_flight_ == 0;
+      }
+      if (finished)
+      {
+        done_.notify();
+      }
+      return;
+    }
+
+    sequences_[token] = next_input_++;
+    forward(ctx, token, 0);
+  }
+}
+
+void pipeline::forward(worker_context const& ctx, uint32_t token, uint32_t stage_index) noexcept
+{
+  if (stage_index == stages_.size())
+  {
+    release_token(ctx, token);
+    return;
+  }
+
+  auto& s = *stages_[stage_index];
+  if (s.mode_ != stage_mode::parallel)
+  {
+    std::scoped_lock lock(s.lock_);
+    if (s.mode_ == stage_mode::serial_in_order)
+    {
+      if (s.busy_ || sequences_[token] != s.next_sequence_)
+      {
+        // At most max_tokens sequences starting at next_sequence_ can be waiting, their slots never collide
+        s.waiting_[sequences_[token] % max_tokens_] = token;
+        return;
+      }
+    }
+    else if (s.busy_)
+    {
+      s.waiting_[s.tail_++ % max_tokens_] = token;
+      return;
+    }
+    s.busy_ = true;
+  }
+
+  ctx.get_scheduler().submit(ctx.get_worker(), s.group_,
+                             ouly::detail::work_item::pbind(
+                              [this, token, stage_index](worker_context const& wc)
+                              {
+                                execute_stage(wc, token, stage_index);
+                              },
+                              s.group_));
+}
+
+auto pipeline::take_waiting(stage& s) noexcept -> uint32_t
+{
+  if (s.mode_ == stage_mode::serial_in_order)
+  {
+    auto& slot  = s.waiting_[++s.next_sequence_ % max_tokens_];
+    auto  token = slot;
+    slot        = no_token;
+    return token;
+  }
+  return s.head_ != s.tail_ ? s.waiting_[s.head_++ % max_tokens_] : no_token;
+}
+
+void pipeline::execute_stage(worker_context const& ctx, uint32_t token, uint32_t stage_index) noexcept
+{
+  auto& s = *stages_[stage_index];
+  while (true)
+  {
+    s.fn_(token, ctx);
+    if (s.mode_ == stage_mode::parallel)
+    {
+      forward(ctx, token, stage_index + 1);
+      return;
+    }
+
+    // A serial stage keeps this worker while tokens are waiting for it
+    uint32_t next = no_token;
+    {
+      std::scoped_lock lock(s.lock_);
+      next = take_waiting(s);
+      if (next == no_token)
+      {
+        s.busy_ = false;
+      }
+    }
+
+    forward(ctx, token, stage_index + 1);
+    if (next == no_token)
+    {
+      return;
+    }
+    token = next;
+  }
+}
+
+void pipeline::release_token(worker_context const& ctx, uint32_t token) noexcept
+{
+  bool finished     = false;
+  bool resume_input = false;
+  {
+    // The input is claimed under the lock, once it is unlocked the pipeline can finish and be destroyed
+    std::scoped_lock lock(lock_);
+    free_tokens_[free_count_++] = token;
+    --in_flight_;
+    finished      = input_done_ && in_flight_ == 0;
+    resume_input  = !input_active_ && !input_done_;
+    input_active_ = input_active_ || resume_input;
+  }
+
+  if (finished)
+  {
+    done_.notify();
+  }
+  else if (resume_input)
+  {
+    submit_input(ctx);
+  }
+}
+
+} // namespace ouly
@@ -1,12 +1,22 @@
 
 #include "ouly/scheduler/scheduler.hpp"
 #include "ouly/scheduler/task.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <latch>
 #include <numeric>
 
 namespace ouly
 {
 
+namespace
+{
+constexpr std::array urgent_lanes    = {task_priority::high};
+constexpr std::array lane_order      = {task_priority::high, task_priority::normal, task_priority::low};
+constexpr std::array aged_lane_order = {task_priority::low, task_priority::normal, task_priority::high};
+} // namespace
+
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 thread_local ouly::detail::worker const* g_worker = nullptr;
 
@@ -30,36 +40,50 @@ scheduler::~scheduler() noexcept
 
 inline void scheduler::do_work(worker_id thread, ouly::detail::work_item& work) noexcept
 {
-  work(workers_[thread.get_index()].contexts_[work.get_compressed_data<ouly::workgroup_id>().get_index()]);
+  auto& worker = workers_[thread.get_index()];
+  auto  group  = work.get_compressed_data<ouly::workgroup_id>().get_index();
+  ouly::detail::worker_counters::increment(worker.stats_.tasks_executed_[group]);
+  OULY_TRACE_EVENT(worker.trace_, trace_event_type::task_begin, group);
+  work(worker.contexts_[group]);
+  OULY_TRACE_EVENT(worker.trace_, trace_event_type::task_end, group);
 }
 
-void scheduler::busy_work(worker_id thread) noexcept
+auto scheduler::busy_work(worker_id thread) noexcept -> bool
 {
   {
     auto& lw = local_work_[thread.get_index()];
     if (lw)
     {
+      ouly::detail::worker_counters::increment(workers_[thread.get_index()].stats_.local_work_hits_);
       do_work(thread, lw);
       lw = nullptr;
-      return;
+      return true;
     }
   }
 
-  work(thread);
+  return work(thread) || (poll_timers(thread) && work(thread));
 }
 
 void scheduler::run(worker_id thread)
 {
   g_worker = &workers_[thread.get_index()];
+  pin_worker(thread);
 
   entry_fn_(worker_desc(thread, group_ranges_[thread.get_index()].mask_));
 
+  auto& stats = workers_[thread.get_index()].stats_;
   while (true)
   {
+    if (auto epoch = reconfigure_epoch_.load(std::memory_order_relaxed); (epoch & 1U) != 0)
+    {
+      wait_for_resume(epoch);
+    }
+
     {
       auto& lw = local_work_[thread.get_index()];
       if (lw)
       {
+        ouly::detail::worker_counters::increment(stats.local_work_hits_);
         do_work(thread, lw);
         lw = nullptr;
       }
@@ -75,13 +99,230 @@ void scheduler::run(worker_id thread)
       break;
     }
 
+    if (poll_timers(thread) || spin_wait(thread))
+    {
+      continue;
+    }
+
     wake_status_[thread.get_index()].store(false);
-    wake_events_[thread.get_index()].wait();
+    // Order the store before the relaxed mailbox check in get_work, a submitter pushes before it reads the status
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // resize_group only notifies workers it sees asleep
+    if ((reconfigure_epoch_.load() & 1U) != 0)
+    {
+      if (wake_status_[thread.get_index()].exchange(true))
+      {
+        wake_events_[thread.get_index()].wait();
+      }
+      continue;
+    }
+
+    // Work submitted after the last poll but before the status was published would not wake this worker up
+    auto wrk = get_work(thread);
+    if (wrk)
+    {
+      if (wake_status_[thread.get_index()].exchange(true))
+      {
+        // A submitter already claimed this worker, consume its notification to see its local work
+        wake_events_[thread.get_index()].wait();
+      }
+      do_work(thread, wrk);
+      continue;
+    }
+
+    park(thread);
   }
 
   workers_[thread.get_index()].quitting_.store(true);
 }
 
+void scheduler::park(worker_id thread) noexcept
+{
+  auto& stats = workers_[thread.get_index()].stats_;
+  ouly::detail::worker_counters::increment(stats.parks_);
+  OULY_TRACE_EVENT(workers_[thread.get_index()].trace_, trace_event_type::park, trace_event::no_group);
+  auto park_start = std::chrono::steady_clock::now();
+
+  auto deadline = next_timer_deadline_.load();
+  if (deadline == ouly::detail::timer_wheel::no_deadline)
+  {
+    wake_events_[thread.get_index()].wait();
+  }
+  else if (!wake_events_[thread.get_index()].wait_until(
+            timer_origin_ + (get_timer_tick_length() * static_cast<std::chrono::nanoseconds::rep>(deadline))))
+  {
+    // Woke up to fire timers, unless a submitter claimed this worker meanwhile in which case its notification is due
+    if (wake_status_[thread.get_index()].exchange(true))
+    {
+      wake_events_[thread.get_index()].wait();
+    }
+  }
+
+  ouly::detail::worker_counters::increment(
+   stats.parked_ns_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now() - park_start)
+                                            .count()));
+  OULY_TRACE_EVENT(workers_[thread.get_index()].trace_, trace_event_type::unpark, trace_event::no_group);
+}
+
+auto scheduler::get_timer_tick() const noexcept -> uint64_t
+{
+  auto elapsed = std::chrono::steady_clock::now() - timer_origin_;
+  return static_cast<uint64_t>(elapsed / get_timer_tick_length());
+}
+
+auto scheduler::poll_timers(worker_id thread) noexcept -> bool
+{
+  if (next_timer_deadline_.load(std::memory_order_relaxed) > get_timer_tick() || !timer_lock_.try_lock())
+  {
+    return false;
+  }
+  auto fired = timers_.advance(get_timer_tick(),
+                               [&](ouly::detail::work_item const& work)
+                               {
+                                 submit(thread, work.get_compressed_data<workgroup_id>(), work);
+                               });
+  next_timer_deadline_.store(timers_.next_deadline(), std::memory_order_relaxed);
+  timer_lock_.unlock();
+  return fired != 0;
+}
+
+auto scheduler::add_timer(std::chrono::nanoseconds delay, std::chrono::nanoseconds period,
+                          ouly::detail::work_item work) -> timer_id
+{
+  auto tick_ns  = get_timer_tick_length().count();
+  auto ceil_div = [tick_ns](std::chrono::nanoseconds::rep value)
+  {
+    return static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>((value + tick_ns - 1) / tick_ns, 0));
+  };
+  auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timer_origin_);
+
+  timer_id id;
+  bool     earliest = false;
+  {
+    auto lck = std::scoped_lock(timer_lock_);
+    id       = timers_.add(work, ceil_div((now + delay).count()),
+                           period.count() > 0 ? std::max<uint64_t>(ceil_div(period.count()), 1) : 0);
+    auto next = timers_.next_deadline();
+    earliest  = next < next_timer_deadline_.load(std::memory_order_relaxed);
+    next_timer_deadline_.store(next);
+  }
+
+  // Parked workers sleep until the previous deadline, wake one up to wait for the new one
+  if (earliest)
+  {
+    for (uint32_t w = 1; w < worker_count_; ++w)
+    {
+      if (!wake_status_[w].exchange(true))
+      {
+        wake_events_[w].notify();
+        break;
+      }
+    }
+  }
+  return id;
+}
+
+auto scheduler::cancel_timer(timer_id timer) noexcept -> bool
+{
+  auto lck       = std::scoped_lock(timer_lock_);
+  auto cancelled = timers_.cancel(timer);
+  next_timer_deadline_.store(timers_.next_deadline(), std::memory_order_relaxed);
+  return cancelled;
+}
+
+auto scheduler::spin_wait(worker_id thread) noexcept -> bool
+{
+  auto const& policy  = options_.idle;
+  auto&       stats   = workers_[thread.get_index()].stats_;
+  uint32_t    backoff = 1;
+
+  for (uint32_t i = 0; i < policy.spin_iterations; ++i)
+  {
+    for (uint32_t p = 0; p < backoff; ++p)
+    {
+      cpu_pause();
+    }
+    backoff = std::min(backoff << 1U, std::max(policy.max_pause_backoff, 1U));
+
+    if (stop_.load(std::memory_order_relaxed))
+    {
+      ouly::detail::worker_counters::increment(stats.spin_polls_, i);
+      return false;
+    }
+    if (work(thread))
+    {
+      ouly::detail::worker_counters::increment(stats.spin_polls_, i + 1);
+      ouly::detail::worker_counters::increment(stats.spin_hits_);
+      return true;
+    }
+  }
+  ouly::detail::worker_counters::increment(stats.spin_polls_, policy.spin_iterations);
+
+  for (uint32_t i = 0; i < policy.yield_iterations; ++i)
+  {
+    std::this_thread::yield();
+
+    if (stop_.load(std::memory_order_relaxed))
+    {
+      ouly::detail::worker_counters::increment(stats.yield_polls_, i);
+      return false;
+    }
+    if (work(thread))
+    {
+      ouly::detail::worker_counters::increment(stats.yield_polls_, i + 1);
+      ouly::detail::worker_counters::increment(stats.yield_hits_);
+      return true;
+    }
+  }
+  ouly::detail::worker_counters::increment(stats.yield_polls_, policy.yield_iterations);
+  return false;
+}
+
+auto scheduler::get_idle_stats(worker_id worker) const noexcept -> worker_idle_stats
+{
+  auto const& stats = workers_[worker.get_index()].stats_;
+  return {.spin_polls  = stats.spin_polls_.load(std::memory_order_relaxed),
+          .yield_polls = stats.yield_polls_.load(std::memory_order_relaxed),
+          .spin_hits   = stats.spin_hits_.load(std::memory_order_relaxed),
+          .yield_hits  = stats.yield_hits_.load(std::memory_order_relaxed),
+          .parks       = stats.parks_.load(std::memory_order_relaxed)};
+}
+
+auto scheduler::collect_stats() const -> scheduler_stats
+{
+  scheduler_stats result;
+  if (!workers_)
+  {
+    return result;
+  }
+  auto load = [](std::atomic_uint64_t const& counter)
+  {
+    return counter.load(std::memory_order_relaxed);
+  };
+  result.workers.resize(worker_count_);
+  for (uint32_t w = 0; w < worker_count_; ++w)
+  {
+    auto const& counters = workers_[w].stats_;
+    auto&       stats    = result.workers[w];
+    stats.tasks_executed.resize(workgroups_.size());
+    for (std::size_t g = 0; g < workgroups_.size(); ++g)
+    {
+      stats.tasks_executed[g] = load(counters.tasks_executed_[g]);
+    }
+    stats.local_pops      = load(counters.local_pops_);
+    stats.shared_pops     = load(counters.shared_pops_);
+    stats.stolen_pops     = load(counters.stolen_pops_);
+    stats.exclusive_pops  = load(counters.exclusive_pops_);
+    stats.local_work_hits = load(counters.local_work_hits_);
+    stats.failed_locks    = load(counters.failed_locks_);
+    stats.parked_ns       = load(counters.parked_ns_);
+    stats.idle            = get_idle_stats(worker_id(w));
+  }
+  return result;
+}
+
 inline auto scheduler::work(worker_id thread) noexcept -> bool
 {
   auto wrk = get_work(thread);
@@ -97,43 +338,207 @@ inline auto scheduler::work(worker_id thread) noexcept -> bool
 
 auto scheduler::get_work(worker_id thread) noexcept -> ouly::detail::work_item
 {
-  auto const& range = group_ranges_[thread.get_index()];
+  auto const& range  = group_ranges_[thread.get_index()];
+  auto&       worker = workers_[thread.get_index()];
+  auto&       stats  = worker.stats_;
+  bool        aged   = options_.priority_aging != 0 && (++worker.lookups_ % options_.priority_aging) == 0;
 
   // try to get work from own queue
   for (uint32_t start = 0; start < range.count_; ++start)
   {
     auto  group_id = range.priority_order_[start];
     auto& group    = workgroups_[group_id];
-    for (uint32_t queue_idx = 0, queue_end = group.thread_count_ - 1; queue_idx <= queue_end; ++queue_idx)
+    auto  offset   = thread.get_index() - group.start_thread_idx_;
+
+    // Aging looks at the shared lanes lowest first, before the worker's own queue, so no lane is starved
+    if (aged || group.shared_->urgent_.load(std::memory_order_relaxed) != 0)
     {
-      auto& queue = group.work_queues_[(thread.get_index() - group.start_thread_idx_ + queue_idx) & queue_end];
-      if (queue.first.try_lock())
+      auto item =
+       pop_shared(group, offset, stats, aged ? std::span<task_priority const>(aged_lane_order) : urgent_lanes);
+      if (item)
       {
-        if (!queue.second.empty())
-        {
-          auto item = queue.second.pop_front_unsafe();
-          queue.first.unlock();
-          return item;
-        }
-        queue.first.unlock();
+        return item;
+      }
+    }
+
+    {
+      ouly::detail::work_item item;
+      if (group.work_deques_ ? group.work_deques_[offset].try_pop(item) : group.local_queues_[offset].try_pop(item))
+      {
+        ouly::detail::worker_counters::increment(stats.local_pops_);
+        return item;
+      }
+    }
+
+    if (!aged)
+    {
+      auto item = pop_shared(group, offset, stats, lane_order);
+      if (item)
+      {
+        return item;
+      }
+    }
+
+    {
+      auto item = steal_work(group, offset);
+      if (item)
+      {
+        ouly::detail::worker_counters::increment(stats.stolen_pops_);
+        OULY_TRACE_EVENT(workers_[thread.get_index()].trace_, trace_event_type::steal, group_id);
+        return item;
       }
     }
   }
 
   // Exclusive
   {
-    auto& worker    = workers_[thread.get_index()];
-    auto& work_list = worker.exlusive_items_;
-    auto  lck       = std::scoped_lock(work_list.first);
-    if (!work_list.second.empty())
+    auto& mailbox = worker.exlusive_items_;
+    if (!mailbox.empty())
+    {
+      if (auto* n = mailbox.try_pop())
+      {
+        ouly::detail::work_item item = n->item_;
+        (n->owner_ < worker_count_ ? workers_[n->owner_].mailbox_nodes_ : external_mailbox_nodes_).release(n);
+        ouly::detail::worker_counters::increment(stats.exclusive_pops_);
+        return item;
+      }
+    }
+  }
+
+  return {};
+}
+
+auto scheduler::pop_shared(ouly::detail::workgroup& group, uint32_t offset, ouly::detail::worker_counters& stats,
+                           std::span<task_priority const> lanes) noexcept -> ouly::detail::work_item
+{
+  // Nothing to take, every worker polls the shared queues so do not touch their locks
+  if (group.shared_->items_.load(std::memory_order_relaxed) == 0)
+  {
+    return {};
+  }
+  for (uint32_t queue_idx = 0; queue_idx < group.thread_count_; ++queue_idx)
+  {
+    auto& queue = group.work_queues_[(offset + queue_idx) % group.thread_count_];
+    if (queue.size_.load(std::memory_order_relaxed) == 0)
+    {
+      continue;
+    }
+    if (!queue.lock_.try_lock())
     {
-      return work_list.second.pop_front_unsafe();
+      ouly::detail::worker_counters::increment(stats.failed_locks_);
+      continue;
     }
+    for (auto priority : lanes)
+    {
+      auto& lane = queue.get_lane(priority);
+      if (!lane.empty())
+      {
+        auto item = lane.pop_front_unsafe();
+        queue.size_.fetch_sub(1, std::memory_order_relaxed);
+        group.shared_->items_.fetch_sub(1, std::memory_order_relaxed);
+        if (priority == task_priority::high)
+        {
+          group.shared_->urgent_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        queue.lock_.unlock();
+        ouly::detail::worker_counters::increment(stats.shared_pops_);
+        return item;
+      }
+    }
+    queue.lock_.unlock();
   }
+  return {};
+}
 
+auto scheduler::steal_work(ouly::detail::workgroup& group, uint32_t offset) noexcept -> ouly::detail::work_item
+{
+  ouly::detail::work_item item;
+  if (group.steal_order_)
+  {
+    auto const* order = group.steal_order_.get() + (static_cast<std::size_t>(offset) * (group.thread_count_ - 1));
+    for (uint32_t i = 0; i + 1 < group.thread_count_; ++i)
+    {
+      auto victim = order[i];
+      if (group.work_deques_ ? group.work_deques_[victim].try_steal(item) : group.local_queues_[victim].try_pop(item))
+      {
+        return item;
+      }
+    }
+    return {};
+  }
+  for (uint32_t i = 1; i < group.thread_count_; ++i)
+  {
+    auto victim = offset + i;
+    if (victim >= group.thread_count_)
+    {
+      victim -= group.thread_count_;
+    }
+    if (group.work_deques_ ? group.work_deques_[victim].try_steal(item) : group.local_queues_[victim].try_pop(item))
+    {
+      return item;
+    }
+  }
   return {};
 }
 
+void scheduler::build_steal_order(ouly::detail::workgroup& group) const
+{
+  auto count = group.thread_count_;
+  auto start = group.start_thread_idx_;
+  if (count < 2 || worker_cpus_.size() < start + count ||
+      std::any_of(worker_cpus_.begin() + start, worker_cpus_.begin() + start + count,
+                  [](cpu_info const& cpu)
+                  {
+                    return cpu.cpu_ == cpu_info::invalid;
+                  }))
+  {
+    group.steal_order_ = nullptr;
+    return;
+  }
+
+  group.steal_order_ = std::make_unique<uint32_t[]>(static_cast<std::size_t>(count) * (count - 1));
+  for (uint32_t offset = 0; offset < count; ++offset)
+  {
+    auto const& self  = worker_cpus_[start + offset];
+    auto*       order = group.steal_order_.get() + (static_cast<std::size_t>(offset) * (count - 1));
+    // Ring order from the thief, then stable sorted by distance so equally close victims keep being spread
+    for (uint32_t i = 1; i < count; ++i)
+    {
+      order[i - 1] = (offset + i) % count;
+    }
+    auto distance = [&](uint32_t victim)
+    {
+      auto const& other = worker_cpus_[start + victim];
+      return other.l3_ == self.l3_ ? 0 : (other.node_ == self.node_ ? 1 : 2);
+    };
+    std::stable_sort(order, order + count - 1,
+                     [&](uint32_t a, uint32_t b)
+                     {
+                       return distance(a) < distance(b);
+                     });
+  }
+}
+
+void scheduler::pin_worker(worker_id thread) const noexcept
+{
+  if (thread.get_index() < worker_cpus_.size() && worker_cpus_[thread.get_index()].cpu_ != cpu_info::invalid)
+  {
+    cpu_topology::pin_current_thread(worker_cpus_[thread.get_index()].cpu_);
+  }
+}
+
+auto scheduler::is_current_worker(worker_id thread) const noexcept -> bool
+{
+  return g_worker == &workers_[thread.get_index()];
+}
+
+auto scheduler::is_worker_thread() const noexcept -> bool
+{
+  auto const* workers = workers_.get();
+  return g_worker != nullptr && workers != nullptr && std::less_equal<>()(workers, g_worker) &&
+         std::less<>()(g_worker, workers + worker_count_);
+}
+
 void scheduler::wake_up(worker_id thread) noexcept
 {
   if (!wake_status_[thread.get_index()].exchange(true))
@@ -143,6 +548,38 @@ void scheduler::wake_up(worker_id thread) noexcept
   }
 }
 
+void scheduler::wake_up_one(ouly::detail::workgroup const& group, worker_id except) noexcept
+{
+  // Order the push before the relaxed status loads, pairs with the fence a worker issues before its last look for work
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  for (uint32_t i = group.start_thread_idx_, end = i + group.thread_count_; i != end; ++i)
+  {
+    if (i != except.get_index() && !wake_status_[i].load(std::memory_order_relaxed) && !wake_status_[i].exchange(true))
+    {
+      wake_events_[i].notify();
+      return;
+    }
+  }
+}
+
+auto scheduler::needs_wake(ouly::detail::workgroup const& group, uint32_t occupancy) const noexcept -> bool
+{
+  auto const& policy = options_.elastic;
+  // Order the push before reading who is awake, a worker publishes that it is going to sleep before its last look
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint32_t awake = 0;
+  for (uint32_t i = group.start_thread_idx_, end = i + group.thread_count_; i != end; ++i)
+  {
+    // The main thread only works while it waits
+    if (i != main_worker_id.get_index() && wake_status_[i].load(std::memory_order_relaxed))
+    {
+      ++awake;
+    }
+  }
+  auto threshold = std::max(policy.wake_threshold, 1U);
+  return awake < std::max(policy.min_active, (occupancy + threshold - 1) / threshold);
+}
+
 void scheduler::begin_execution(scheduler_worker_entry&& entry, void* user_context)
 {
   local_work_   = std::make_unique<ouly::detail::work_item[]>(worker_count_);
@@ -154,42 +591,27 @@ void scheduler::begin_execution(scheduler_worker_entry&& entry, void* user_conte
 
   threads_.reserve(worker_count_ - 1);
 
-  auto wgroup_count = static_cast<uint32_t>(workgroups_.size());
-
-  for (uint32_t group = 0; group < wgroup_count; ++group)
+  for (auto& g : workgroups_)
   {
-    auto const& g = workgroups_[group];
-
-    for (uint32_t i = g.start_thread_idx_, end = g.thread_count_ + i; i < end; ++i)
-    {
-      auto& range = group_ranges_[i];
-      range.mask_ |= 1U << group;
-      range.priority_order_[range.count_++] = static_cast<uint8_t>(group);
-    }
+    init_group_queues(g);
   }
+  build_group_ranges();
 
   for (uint32_t w = 0; w < worker_count_; ++w)
   {
-    auto& worker = workers_[w];
-    worker.id_   = worker_id(w);
-    auto& range  = group_ranges_[w];
-
-    std::sort(range.priority_order_.data(), range.priority_order_.data() + range.count_,
-              [&](uint8_t first, uint8_t second)
-              {
-                return workgroups_[first].priority_ == workgroups_[second].priority_
-                        ? first < second
-                        : workgroups_[first].priority_ > workgroups_[second].priority_;
-              });
-
-    worker.contexts_ = std::make_unique<worker_context[]>(wgroup_count);
-    for (uint32_t g = 0; g < wgroup_count; ++g)
-    {
-      worker.contexts_[g] = worker_context(*this, user_context, worker_id(w), workgroup_id(g), group_ranges_[w].mask_,
-                                           w - workgroups_[g].start_thread_idx_);
-    }
+    auto& worker     = workers_[w];
+    worker.id_       = worker_id(w);
+    worker.contexts_ = std::make_unique<worker_context[]>(workgroups_.size());
     wake_status_[w].store(true);
+#ifdef OULY_SCHEDULER_TRACE
+    worker.trace_.reset(options_.trace_capacity);
+#endif
   }
+  build_contexts(user_context);
+  trace_origin_ = ouly::detail::trace_clock_sample::now();
+  timer_origin_ = std::chrono::steady_clock::now();
+  timers_.reset(0);
+  next_timer_deadline_.store(ouly::detail::timer_wheel::no_deadline);
 
   stop_              = false;
   auto start_counter = std::latch(worker_count_);
@@ -203,6 +625,7 @@ void scheduler::begin_execution(scheduler_worker_entry&& entry, void* user_conte
     start_counter.count_down();
   };
 
+  pin_worker(worker_id(0));
   entry_fn_(worker_desc(worker_id(0), group_ranges_[0].mask_));
 
   for (uint32_t thread = 1; thread < worker_count_; ++thread)
@@ -215,6 +638,94 @@ void scheduler::begin_execution(scheduler_worker_entry&& entry, void* user_conte
   entry_fn_ = {};
 }
 
+void scheduler::init_group_queues(ouly::detail::workgroup& group) const
+{
+  if (options_.queue_mode == work_queue_mode::work_stealing)
+  {
+    group.work_deques_ = std::make_unique<ouly::detail::work_deque[]>(group.thread_count_);
+    for (uint32_t q = 0; q < group.thread_count_; ++q)
+    {
+      group.work_deques_[q].reset(options_.deque_capacity);
+    }
+  }
+  else
+  {
+    group.local_queues_ = std::make_unique<ouly::detail::local_queue[]>(group.thread_count_);
+  }
+  build_steal_order(group);
+}
+
+void scheduler::build_group_ranges() noexcept
+{
+  for (uint32_t w = 0; w < worker_count_; ++w)
+  {
+    group_ranges_[w] = {};
+  }
+
+  for (uint32_t group = 0, count = static_cast<uint32_t>(workgroups_.size()); group < count; ++group)
+  {
+    auto const& g = workgroups_[group];
+    for (uint32_t i = g.start_thread_idx_, end = g.thread_count_ + i; i < end; ++i)
+    {
+      auto& range = group_ranges_[i];
+      range.mask_ |= 1U << group;
+      range.priority_order_[range.count_++] = static_cast<uint8_t>(group);
+    }
+  }
+
+  for (uint32_t w = 0; w < worker_count_; ++w)
+  {
+    auto& range = group_ranges_[w];
+    std::sort(range.priority_order_.data(), range.priority_order_.data() + range.count_,
+              [&](uint8_t first, uint8_t second)
+              {
+                return workgroups_[first].priority_ == workgroups_[second].priority_
+                        ? first < second
+                        : workgroups_[first].priority_ > workgroups_[second].priority_;
+              });
+  }
+}
+
+void scheduler::build_contexts(void* user_context) noexcept
+{
+  // Assigned in place, references to contexts stay valid
+  for (uint32_t w = 0; w < worker_count_; ++w)
+  {
+    for (uint32_t g = 0, count = static_cast<uint32_t>(workgroups_.size()); g < count; ++g)
+    {
+      workers_[w].contexts_[g] = worker_context(*this, user_context, worker_id(w), workgroup_id(g),
+                                                group_ranges_[w].mask_, w - workgroups_[g].start_thread_idx_);
+    }
+  }
+}
+
+auto scheduler::drain_trace() -> std::vector<trace_event>
+{
+  std::vector<trace_event> events;
+#ifdef OULY_SCHEDULER_TRACE
+  if (!workers_)
+  {
+    return events;
+  }
+  // Calibrate the trace clock against steady_clock over the whole recording
+  auto now            = ouly::detail::trace_clock_sample::now();
+  auto nanos_per_tick = now.ticks_ > trace_origin_.ticks_ ? static_cast<double>(now.nanos_ - trace_origin_.nanos_) /
+                                                             static_cast<double>(now.ticks_ - trace_origin_.ticks_)
+                                                          : 1.0;
+  for (uint32_t w = 0; w < worker_count_; ++w)
+  {
+    workers_[w].trace_.drain(events, w, trace_origin_, nanos_per_tick);
+  }
+  std::ranges::stable_sort(events, {}, &trace_event::timestamp_);
+#endif
+  return events;
+}
+
+void scheduler::write_chrome_trace(std::ostream& out)
+{
+  ouly::write_chrome_trace(out, drain_trace());
+}
+
 void scheduler::take_ownership() noexcept
 {
   g_worker = &workers_[0];
@@ -232,8 +743,12 @@ void scheduler::finish_pending_tasks() noexcept
       bool has_items = false;
       for (uint32_t q = 0; q < group.thread_count_; ++q)
       {
-        auto lck = std::scoped_lock(group.work_queues_[q].first);
-        has_items |= !group.work_queues_[q].second.empty();
+        auto lck = std::scoped_lock(group.work_queues_[q].lock_);
+        has_items |= !group.work_queues_[q].empty();
+      }
+      for (uint32_t q = 0; q < group.thread_count_; ++q)
+      {
+        has_items |= group.work_deques_ ? !group.work_deques_[q].empty() : !group.local_queues_[q].empty();
       }
       if (has_items)
       {
@@ -248,12 +763,7 @@ void scheduler::finish_pending_tasks() noexcept
 
     for (uint32_t w = 0; w < worker_count_; ++w)
     {
-      auto& worker    = workers_[w];
-      bool  has_items = false;
-      {
-        auto lck  = std::scoped_lock(worker.exlusive_items_.first);
-        has_items = !worker.exlusive_items_.second.empty();
-      }
+      bool has_items = !workers_[w].exlusive_items_.empty();
 
       has_work |= has_items;
       if (!has_items)
@@ -281,21 +791,33 @@ void scheduler::end_execution()
     threads_[thread - 1].join();
   }
   threads_.clear();
+  timers_.reset(0);
+  next_timer_deadline_.store(ouly::detail::timer_wheel::no_deadline);
 }
 
 void scheduler::submit(worker_id src, worker_id dst, ouly::detail::work_item work)
 {
+  OULY_TRACE_EVENT(workers_[src.get_index()].trace_, trace_event_type::submit,
+                   work.get_compressed_data<ouly::workgroup_id>().get_index());
   if (src == dst)
   {
     do_work(src, work);
   }
   else
   {
+    ouly::detail::mailbox_pool::node* n = nullptr;
+    if (is_current_worker(src))
+    {
+      n = workers_[src.get_index()].mailbox_nodes_.acquire(src.get_index());
+    }
+    else
     {
-      auto& worker = workers_[dst.get_index()];
-      auto  lck    = std::scoped_lock(worker.exlusive_items_.first);
-      worker.exlusive_items_.second.emplace_back(std::move(work));
+      // Pools are owner only, any other thread shares the external pool
+      auto lck = std::scoped_lock(external_mailbox_lock_);
+      n        = external_mailbox_nodes_.acquire(worker_count_);
     }
+    n->item_ = std::move(work);
+    workers_[dst.get_index()].exlusive_items_.push(n);
     if (!wake_status_[dst.get_index()].exchange(true))
     {
       wake_events_[dst.get_index()].notify();
@@ -303,11 +825,28 @@ void scheduler::submit(worker_id src, worker_id dst, ouly::detail::work_item wor
   }
 }
 
-void scheduler::submit([[maybe_unused]] worker_id src, workgroup_id dst, ouly::detail::work_item work)
+void scheduler::submit(worker_id src, workgroup_id dst, ouly::detail::work_item work)
 {
   auto& wg = workgroups_[dst.get_index()];
+  OULY_TRACE_EVENT(workers_[src.get_index()].trace_, trace_event_type::submit, dst.get_index());
+
+  // Owner push into its own deque or local ring, a sleeping worker is woken up to steal from it
+  if ((group_ranges_[src.get_index()].mask_ & (1U << dst.get_index())) != 0U && is_current_worker(src))
+  {
+    auto offset = src.get_index() - wg.start_thread_idx_;
+    if (wg.work_deques_ ? wg.work_deques_[offset].try_push(work) : wg.local_queues_[offset].try_push(work))
+    {
+      if (!options_.elastic.enabled ||
+          needs_wake(wg, wg.work_deques_ ? wg.work_deques_[offset].size() : wg.local_queues_[offset].size()))
+      {
+        wake_up_one(wg, src);
+      }
+      return;
+    }
+  }
 
-  for (uint32_t i = wg.start_thread_idx_, end = i + wg.thread_count_; i != end; ++i)
+  // Elastic parking leaves the choice of waking a worker to push_shared
+  for (uint32_t i = wg.start_thread_idx_, end = i + wg.thread_count_; i != end && !options_.elastic.enabled; ++i)
   {
     if (!wake_status_[i].exchange(true))
     {
@@ -317,17 +856,120 @@ void scheduler::submit([[maybe_unused]] worker_id src, workgroup_id dst, ouly::d
     }
   }
 
+  push_shared(wg, std::move(work), task_priority::normal);
+}
+
+void scheduler::submit(worker_id src, workgroup_id dst, ouly::detail::work_item work, task_priority priority)
+{
+  if (priority == task_priority::normal)
+  {
+    submit(src, dst, std::move(work));
+    return;
+  }
+
+  auto& wg = workgroups_[dst.get_index()];
+  OULY_TRACE_EVENT(workers_[src.get_index()].trace_, trace_event_type::submit, dst.get_index());
+
+  if (priority == task_priority::high)
+  {
+    // A sleeping worker runs it before anything else
+    for (uint32_t i = wg.start_thread_idx_, end = i + wg.thread_count_; i != end; ++i)
+    {
+      if (i != src.get_index() && !wake_status_[i].load(std::memory_order_relaxed) && !wake_status_[i].exchange(true))
+      {
+        local_work_[i] = work;
+        wake_events_[i].notify();
+        return;
+      }
+    }
+  }
+
+  push_shared(wg, std::move(work), priority);
+}
+
+void scheduler::submit_any(workgroup_id dst, ouly::detail::work_item work)
+{
+  // A worker must not wait in submit_external for a resize_group that waits for it
+  if (is_worker_thread())
+  {
+    submit(g_worker->id_, dst, std::move(work));
+  }
+  else
+  {
+    submit_external(dst, std::move(work));
+  }
+}
+
+void scheduler::enter_external() noexcept
+{
+  while (true)
+  {
+    external_submits_.fetch_add(1);
+    auto epoch = reconfigure_epoch_.load();
+    if ((epoch & 1U) == 0)
+    {
+      return;
+    }
+    external_submits_.fetch_sub(1);
+    reconfigure_epoch_.wait(epoch);
+  }
+}
+
+void scheduler::leave_external() noexcept
+{
+  external_submits_.fetch_sub(1);
+}
+
+void scheduler::submit_external(workgroup_id dst, ouly::detail::work_item work)
+{
+  enter_external();
+  auto& wg      = workgroups_[dst.get_index()];
+  bool  claimed = false;
+  for (uint32_t i = wg.start_thread_idx_, end = i + wg.thread_count_; i != end && !options_.elastic.enabled; ++i)
+  {
+    if (!wake_status_[i].load(std::memory_order_relaxed) && !wake_status_[i].exchange(true))
+    {
+      local_work_[i] = work;
+      wake_events_[i].notify();
+      claimed = true;
+      break;
+    }
+  }
+  if (!claimed)
+  {
+    push_shared(wg, std::move(work), task_priority::normal);
+  }
+  leave_external();
+}
+
+void scheduler::push_shared(ouly::detail::workgroup& wg, ouly::detail::work_item work, task_priority lane)
+{
   while (true)
   {
-    wg.push_offset_++;
-    for (uint32_t i = 0, end = wg.thread_count_ - 1; i <= end; ++i)
+    uint32_t offset = wg.shared_->push_offset_.fetch_add(1, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < wg.thread_count_; ++i)
     {
-      uint32_t q     = (wg.push_offset_ + i) & end;
+      uint32_t q     = (offset + i) % wg.thread_count_;
       auto&    queue = wg.work_queues_[q];
-      if (queue.first.try_lock())
+      if (queue.lock_.try_lock())
       {
-        queue.second.emplace_back(std::move(work));
-        queue.first.unlock();
+        queue.get_lane(lane).emplace_back(std::move(work));
+        auto occupancy = queue.size_.fetch_add(1, std::memory_order_relaxed) + 1;
+        wg.shared_->items_.fetch_add(1, std::memory_order_relaxed);
+        if (lane == task_priority::high)
+        {
+          wg.shared_->urgent_.fetch_add(1, std::memory_order_relaxed);
+        }
+        queue.lock_.unlock();
+        if (options_.elastic.enabled)
+        {
+          // Any awake worker of the group picks it up, the queue's owner is not special
+          if (needs_wake(wg, occupancy))
+          {
+            wake_up_one(wg, main_worker_id);
+          }
+          return;
+        }
         q += wg.start_thread_idx_;
         if (!wake_status_[q].exchange(true))
         {
@@ -359,12 +1001,155 @@ auto scheduler::create_group(uint32_t thread_offset, uint32_t thread_count, uint
   return workgroup_id(static_cast<uint32_t>(workgroups_.size() - 1));
 }
 
+void scheduler::create_group(workgroup_id group, uint32_t thread_offset, cpu_topology const& topology,
+                             std::span<uint32_t const> cpus, uint32_t priority)
+{
+  auto count = static_cast<uint32_t>(cpus.size());
+  create_group(group, thread_offset, count, priority);
+  if (worker_cpus_.size() < thread_offset + count)
+  {
+    worker_cpus_.resize(thread_offset + count);
+  }
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    auto const* info = topology.find(cpus[i]);
+    assert(info && "Cpu is not part of the topology");
+    auto& placement = worker_cpus_[thread_offset + i];
+    assert((placement.cpu_ == cpu_info::invalid || placement.cpu_ == info->cpu_) &&
+           "Worker is already pinned to a different cpu by another group");
+    if (info != nullptr)
+    {
+      placement = *info;
+    }
+  }
+}
+
+void scheduler::resize_group(workgroup_id group, uint32_t thread_offset, uint32_t thread_count)
+{
+  reconfigure_group(group, thread_offset, thread_count, workgroups_[group.get_index()].priority_);
+}
+
+void scheduler::set_group_priority(workgroup_id group, uint32_t priority)
+{
+  auto const& wg = workgroups_[group.get_index()];
+  reconfigure_group(group, wg.start_thread_idx_, wg.thread_count_, priority);
+}
+
+void scheduler::reconfigure_group(workgroup_id group, uint32_t thread_offset, uint32_t thread_count,
+                                  uint32_t priority)
+{
+  if (!workers_ || stop_.load())
+  {
+    create_group(group, thread_offset, thread_count, priority);
+    return;
+  }
+
+  assert(group.get_index() < workgroups_.size() && "Only groups created before begin_execution can be resized");
+  assert(thread_count > 0 && thread_offset + thread_count <= worker_count_ &&
+         "Group must stay within the workers created by begin_execution");
+
+  pause_workers();
+
+  // Collect what is still queued on the old layout, shared lanes keep their priority
+  auto& wg = workgroups_[group.get_index()];
+  std::vector<std::pair<ouly::detail::work_item, task_priority>> pending;
+  for (uint32_t q = 0; q < wg.thread_count_; ++q)
+  {
+    for (auto lane : lane_order)
+    {
+      auto& items = wg.work_queues_[q].get_lane(lane);
+      while (!items.empty())
+      {
+        pending.emplace_back(items.pop_front_unsafe(), lane);
+      }
+    }
+    ouly::detail::work_item item;
+    while (wg.work_deques_ ? wg.work_deques_[q].try_steal(item) : wg.local_queues_[q].try_pop(item))
+    {
+      pending.emplace_back(item, task_priority::normal);
+    }
+  }
+
+  // Handoffs claimed for workers that leave the group, they would run them outside of it
+  for (uint32_t w = wg.start_thread_idx_, end = w + wg.thread_count_; w != end; ++w)
+  {
+    auto& lw = local_work_[w];
+    if (lw && (w < thread_offset || w >= thread_offset + thread_count) &&
+        lw.get_compressed_data<workgroup_id>() == group)
+    {
+      pending.emplace_back(std::move(lw), task_priority::normal);
+      lw = nullptr;
+    }
+  }
+
+  wg.create_group(thread_offset, thread_count, priority);
+  init_group_queues(wg);
+  for (std::size_t i = 0; i < pending.size(); ++i)
+  {
+    auto& [item, lane] = pending[i];
+    auto& queue = wg.work_queues_[i % thread_count];
+    queue.get_lane(lane).emplace_back(std::move(item));
+    queue.size_.fetch_add(1, std::memory_order_relaxed);
+    wg.shared_->items_.fetch_add(1, std::memory_order_relaxed);
+    if (lane == task_priority::high)
+    {
+      wg.shared_->urgent_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  build_group_ranges();
+  build_contexts(workers_[0].contexts_[0].get_user_context<void>());
+
+  resume_workers();
+  if (!pending.empty())
+  {
+    for (uint32_t w = thread_offset; w < thread_offset + thread_count; ++w)
+    {
+      wake_up(worker_id(w));
+    }
+  }
+}
+
+void scheduler::pause_workers() noexcept
+{
+  reconfigure_epoch_.fetch_add(1);
+  while (external_submits_.load() != 0)
+  {
+    std::this_thread::yield();
+  }
+  for (uint32_t w = 1; w < worker_count_; ++w)
+  {
+    wake_up(worker_id(w));
+  }
+  for (auto paused = paused_workers_.load(); paused != worker_count_ - 1; paused = paused_workers_.load())
+  {
+    paused_workers_.wait(paused);
+  }
+}
+
+void scheduler::resume_workers() noexcept
+{
+  paused_workers_.store(0);
+  reconfigure_epoch_.fetch_add(1);
+  reconfigure_epoch_.notify_all();
+}
+
+void scheduler::wait_for_resume(uint32_t epoch) noexcept
+{
+  paused_workers_.fetch_add(1);
+  paused_workers_.notify_one();
+  reconfigure_epoch_.wait(epoch);
+}
+
 void scheduler::clear_group(workgroup_id group)
 {
   workgroups_[group.get_index()].start_thread_idx_ = 0;
   workgroups_[group.get_index()].thread_count_     = 0;
-  workgroups_[group.get_index()].push_offset_      = 0;
   workgroups_[group.get_index()].work_queues_      = nullptr;
+  workgroups_[group.get_index()].shared_           = nullptr;
+  workgroups_[group.get_index()].work_deques_      = nullptr;
+  workgroups_[group.get_index()].local_queues_     = nullptr;
+  workgroups_[group.get_index()].steal_order_      = nullptr;
 }
 
 } // namespace ouly
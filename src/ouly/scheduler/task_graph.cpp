@@ -0,0 +1,151 @@
+#include "ouly/scheduler/task_graph.hpp"
+#include <cassert>
+#include <vector>
+
+namespace ouly
+{
+
+auto task_graph::add_node(workgroup_id group, task_delegate task) -> node_id
+{
+  assert(!finalized_ && "Graph is finalized, nodes cannot be added");
+  auto id = static_cast<node_id>(nodes_.size());
+  nodes_.emplace_back(node{.task_ = std::move(task), .group_ = group});
+  return id;
+}
+
+void task_graph::add_edge(node_id before, node_id after)
+{
+  assert(!finalized_ && "Graph is finalized, edges cannot be added");
+  assert(before < nodes_.size() && after < nodes_.size() && before != after);
+  edges_.emplace_back(before, after);
+}
+
+auto task_graph::finalize() -> bool
+{
+  for (auto& n : nodes_)
+  {
+    n.predecessor_count_ = 0;
+    n.successor_count_   = 0;
+  }
+
+  for (auto [before, after] : edges_)
+  {
+    nodes_[before].successor_count_++;
+    nodes_[after].predecessor_count_++;
+  }
+
+  uint32_t offset = 0;
+  for (auto& n : nodes_)
+  {
+    n.first_successor_ = offset;
+    offset += n.successor_count_;
+    n.successor_count_ = 0;
+  }
+
+  successors_.resize(edges_.size());
+  for (auto [before, after] : edges_)
+  {
+    auto& n                                                = nodes_[before];
+    successors_[n.first_successor_ + n.successor_count_++] = after;
+  }
+
+  roots_.clear();
+  for (node_id i = 0, end = get_node_count(); i < end; ++i)
+  {
+    if (nodes_[i].predecessor_count_ == 0)
+    {
+      roots_.push_back(i);
+    }
+  }
+
+  // Kahn's traversal from the roots, nodes on or behind a cycle are never reached
+  std::vector<uint32_t> pending(nodes_.size());
+  std::vector<node_id>  ready(roots_);
+  for (node_id i = 0, end = get_node_count(); i < end; ++i)
+  {
+    pending[i] = nodes_[i].predecessor_count_;
+  }
+  uint32_t visited = 0;
+  while (!ready.empty())
+  {
+    auto const& n = nodes_[ready.back()];
+    ready.pop_back();
+    visited++;
+    for (uint32_t i = n.first_successor_, end = i + n.successor_count_; i < end; ++i)
+    {
+      if (--pending[successors_[i]] == 0)
+      {
+        ready.push_back(successors_[i]);
+      }
+    }
+  }
+  if (visited != get_node_count())
+  {
+    return false;
+  }
+
+  pending_   = std::make_unique<std::atomic_uint32_t[]>(nodes_.size());
+  finalized_ = true;
+  return true;
+}
+
+void task_graph::start(worker_context const& ctx) noexcept
+{
+  assert(finalized_ && "Graph must be finalized before execution");
+
+  for (node_id i = 0, end = get_node_count(); i < end; ++i)
+  {
+    pending_[i].store(nodes_[i].predecessor_count_, std::memory_order_relaxed);
+  }
+  remaining_.store(get_node_count(), std::memory_order_release);
+
+  if (nodes_.empty())
+  {
+    done_.notify();
+    return;
+  }
+
+  for (auto root : roots_)
+  {
+    submit_node(ctx, root);
+  }
+}
+
+void task_graph::wait(worker_context const& ctx)
+{
+  done_.wait(ctx.get_worker(), ctx.get_scheduler());
+}
+
+void task_graph::submit_node(worker_context const& ctx, node_id id) noexcept
+{
+  auto group = nodes_[id].group_;
+  ctx.get_scheduler().submit(ctx.get_worker(), group,
+                             ouly::detail::work_item::pbind(
+                              [this, id](worker_context const& wc)
+                              {
+                                execute_node(wc, id);
+                              },
+                              group));
+}
+
+void task_graph::execute_node(worker_context const& ctx, node_id id) noexcept
+{
+  auto& n = nodes_[id];
+  n.task_(ctx);
+
+  for (uint32_t i = n.first_successor_, end = i + n.successor_count_; i < end; ++i)
+  {
+    auto succ = successors_[i];
+    if (pending_[succ].fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      submit_node(ctx, succ);
+    }
+  }
+
+  if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    done_.notify();
+  }
+}
+
+} // namespace ouly
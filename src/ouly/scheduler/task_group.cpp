@@ -0,0 +1,160 @@
+#include "ouly/scheduler/task_group.hpp"
+#include <cassert>
+#include <mutex>
+
+namespace ouly
+{
+namespace
+{
+// Busy rounds of a waiter without any work before it parks
+constexpr uint32_t wait_spin_rounds = 64;
+// Recycled states kept per thread
+constexpr uint32_t max_cached_states = 64;
+
+struct task_group_state_cache
+{
+  task_group_state_cache() noexcept                                        = default;
+  task_group_state_cache(task_group_state_cache const&)                    = delete;
+  task_group_state_cache(task_group_state_cache&&)                         = delete;
+  auto operator=(task_group_state_cache const&) -> task_group_state_cache& = delete;
+  auto operator=(task_group_state_cache&&) -> task_group_state_cache&      = delete;
+
+  ~task_group_state_cache() noexcept
+  {
+    while (free_ != nullptr)
+    {
+      auto* next = free_->next_free_;
+      delete free_; // NOLINT(cppcoreguidelines-owning-memory)
+      free_ = next;
+    }
+  }
+
+  ouly::detail::task_group_state* free_ = nullptr;
+  uint32_t                        size_ = 0;
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+thread_local task_group_state_cache t_state_cache;
+
+/**
+ * @brief Execute one pending child of the group, returns false if none is left
+ */
+auto run_one(ouly::detail::task_group_state& state, worker_context const& ctx) noexcept -> bool
+{
+  task_delegate task;
+  {
+    auto lck = std::scoped_lock(state.lock_);
+    if (state.tasks_.empty())
+    {
+      return false;
+    }
+    task = std::move(state.tasks_.back());
+    state.tasks_.pop_back();
+  }
+
+  task(ctx);
+  if (state.pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    state.pending_.notify_all();
+  }
+  return true;
+}
+} // namespace
+
+namespace detail
+{
+auto acquire_task_group_state() -> task_group_state*
+{
+  auto& cache = t_state_cache;
+  if (cache.free_ == nullptr)
+  {
+    return new task_group_state(); // NOLINT(cppcoreguidelines-owning-memory)
+  }
+  auto* state  = cache.free_;
+  cache.free_  = state->next_free_;
+  cache.size_ -= 1;
+  state->references_.store(1, std::memory_order_relaxed);
+  return state;
+}
+
+void release_task_group_state(task_group_state* state) noexcept
+{
+  if (state->references_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+  {
+    return;
+  }
+
+  auto& cache = t_state_cache;
+  if (cache.size_ == max_cached_states)
+  {
+    delete state; // NOLINT(cppcoreguidelines-owning-memory)
+    return;
+  }
+  // The children vector keeps its capacity, a recycled group does not allocate
+  state->next_free_ = cache.free_;
+  cache.free_       = state;
+  cache.size_ += 1;
+}
+} // namespace detail
+
+task_group::~task_group() noexcept
+{
+  assert(state_->pending_.load() == 0 && "task_group destroyed with pending children, call wait first");
+  ouly::detail::release_task_group_state(state_);
+}
+
+void task_group::run(worker_context const& ctx, task_delegate task)
+{
+  auto* state = state_;
+  state->pending_.fetch_add(1, std::memory_order_relaxed);
+  state->references_.fetch_add(1, std::memory_order_relaxed);
+  {
+    auto lck = std::scoped_lock(state->lock_);
+    state->tasks_.emplace_back(std::move(task));
+  }
+
+  // The runner may find its child already executed by the waiter, it only holds on to the state
+  ctx.get_scheduler().submit(ctx.get_worker(), group_,
+                             ouly::detail::work_item::pbind(
+                              [state](worker_context const& wc)
+                              {
+                                run_one(*state, wc);
+                                ouly::detail::release_task_group_state(state);
+                              },
+                              group_));
+}
+
+void task_group::wait(worker_context const& ctx)
+{
+  auto& state     = *state_;
+  auto& scheduler = ctx.get_scheduler();
+  // Children can only be executed on a worker of their workgroup
+  bool     own_children = ctx.belongs_to(group_);
+  uint32_t idle_rounds  = 0;
+  while (true)
+  {
+    auto pending = state.pending_.load(std::memory_order_acquire);
+    if (pending == 0)
+    {
+      return;
+    }
+
+    if ((own_children && run_one(state, worker_context::get(group_))) || scheduler.busy_work(ctx.get_worker()))
+    {
+      idle_rounds = 0;
+      continue;
+    }
+
+    if (++idle_rounds < wait_spin_rounds)
+    {
+      ouly::cpu_pause();
+      continue;
+    }
+
+    // Every child is running on another worker, the last one to finish notifies
+    state.pending_.wait(pending, std::memory_order_acquire);
+    idle_rounds = 0;
+  }
+}
+
+} // namespace ouly
@@ -0,0 +1,166 @@
+
+#include "ouly/scheduler/detail/timer_wheel.hpp"
+#include <bit>
+
+namespace ouly::detail
+{
+
+void timer_wheel::reset(uint64_t now) noexcept
+{
+  for (uint32_t level = 0; level < level_count; ++level)
+  {
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+      for (auto index = take_slot(level, slot); index != nil;)
+      {
+        auto following = get_node(index).next_;
+        release(index);
+        index = following;
+      }
+    }
+  }
+  current_tick_ = now;
+}
+
+auto timer_wheel::add(work_item const& work, uint64_t deadline, uint64_t period) -> timer_id
+{
+  if (free_ == nil)
+  {
+    auto first = static_cast<uint32_t>(blocks_.size()) * block_size;
+    blocks_.emplace_back(std::make_unique<node[]>(block_size));
+    for (uint32_t i = block_size; i > 0; --i)
+    {
+      get_node(first + i - 1).next_ = free_;
+      free_                         = first + i - 1;
+    }
+  }
+
+  auto  index = free_;
+  auto& n     = get_node(index);
+  free_       = n.next_;
+  n.work_     = work;
+  n.deadline_ = std::max(deadline, current_tick_ + 1);
+  n.period_   = period;
+  link(index);
+  ++size_;
+  return timer_id{.index_ = index, .generation_ = n.generation_};
+}
+
+auto timer_wheel::cancel(timer_id id) noexcept -> bool
+{
+  if (id.index_ >= blocks_.size() * block_size)
+  {
+    return false;
+  }
+  auto& n = get_node(id.index_);
+  if (n.generation_ != id.generation_ || n.slot_ == nil)
+  {
+    return false;
+  }
+  unlink(id.index_);
+  release(id.index_);
+  return true;
+}
+
+auto timer_wheel::next_deadline() const noexcept -> uint64_t
+{
+  uint64_t next = no_deadline;
+  for (uint32_t level = 0; level < level_count; ++level)
+  {
+    if (occupied_[level] == 0)
+    {
+      continue;
+    }
+    // First occupied slot after the current one, every timer of a level is at least one slot ahead of the wheel
+    auto shift   = level * level_bits;
+    auto current = current_tick_ >> shift;
+    auto rotated = std::rotr(occupied_[level], static_cast<int>((current + 1) & (slot_count - 1)));
+    auto ahead   = static_cast<uint64_t>(std::countr_zero(rotated)) + 1;
+    next         = std::min(next, (current + ahead) << shift);
+  }
+  return next;
+}
+
+void timer_wheel::link(uint32_t index) noexcept
+{
+  auto& n = get_node(index);
+
+  uint32_t level = 0;
+  uint64_t slot  = 0;
+  for (; level < level_count; ++level)
+  {
+    auto shift = level * level_bits;
+    if ((n.deadline_ >> shift) - (current_tick_ >> shift) < slot_count)
+    {
+      slot = n.deadline_ >> shift;
+      break;
+    }
+  }
+  if (level == level_count)
+  {
+    // Beyond the wheel's range, park in the farthest top level slot and get re-linked when it is reached
+    level = level_count - 1;
+    slot  = (current_tick_ >> (level * level_bits)) + slot_count - 1;
+  }
+
+  auto  slot_index = static_cast<uint32_t>(slot) & (slot_count - 1);
+  auto& head       = slots_[level][slot_index];
+  n.prev_          = nil;
+  n.next_          = head;
+  n.slot_          = (level * slot_count) + slot_index;
+  if (head != nil)
+  {
+    get_node(head).prev_ = index;
+  }
+  head = index;
+  occupied_[level] |= uint64_t{1} << slot_index;
+}
+
+void timer_wheel::unlink(uint32_t index) noexcept
+{
+  auto& n     = get_node(index);
+  auto  level = n.slot_ / slot_count;
+  auto  slot  = n.slot_ % slot_count;
+  if (n.prev_ != nil)
+  {
+    get_node(n.prev_).next_ = n.next_;
+  }
+  else
+  {
+    slots_[level][slot] = n.next_;
+    if (n.next_ == nil)
+    {
+      occupied_[level] &= ~(uint64_t{1} << slot);
+    }
+  }
+  if (n.next_ != nil)
+  {
+    get_node(n.next_).prev_ = n.prev_;
+  }
+  n.slot_ = nil;
+}
+
+void timer_wheel::release(uint32_t index) noexcept
+{
+  auto& n = get_node(index);
+  n.generation_++;
+  n.slot_ = nil;
+  n.work_ = {};
+  n.next_ = free_;
+  free_   = index;
+  --size_;
+}
+
+auto timer_wheel::take_slot(uint32_t level, uint32_t slot) noexcept -> uint32_t
+{
+  auto head           = slots_[level][slot];
+  slots_[level][slot] = nil;
+  occupied_[level] &= ~(uint64_t{1} << slot);
+  for (auto index = head; index != nil; index = get_node(index).next_)
+  {
+    get_node(index).slot_ = nil;
+  }
+  return head;
+}
+
+} // namespace ouly::detail
@@ -0,0 +1,92 @@
+
+#include "ouly/scheduler/trace.hpp"
+#include <iomanip>
+#include <ostream>
+#include <set>
+
+namespace ouly
+{
+
+namespace
+{
+constexpr uint64_t nanos_per_micro = 1000;
+
+void write_timestamp(std::ostream& out, uint64_t nanos)
+{
+  // Chrome expects microseconds, keep nanosecond precision as a fraction
+  auto fill = out.fill('0');
+  out << nanos / nanos_per_micro << '.' << std::setw(3) << nanos % nanos_per_micro;
+  out.fill(fill);
+}
+
+auto get_phase(trace_event_type type) noexcept -> char
+{
+  switch (type)
+  {
+  case trace_event_type::task_begin:
+  case trace_event_type::park:
+    return 'B';
+  case trace_event_type::task_end:
+  case trace_event_type::unpark:
+    return 'E';
+  case trace_event_type::submit:
+  case trace_event_type::steal:
+  default:
+    return 'i';
+  }
+}
+} // namespace
+
+void write_chrome_trace(std::ostream& out, std::span<trace_event const> events)
+{
+  out << R"({"displayTimeUnit":"ns","traceEvents":[)";
+
+  std::set<uint32_t> workers;
+  bool               first = true;
+  for (auto const& event : events)
+  {
+    workers.insert(event.worker_);
+    out << (first ? "\n" : ",\n");
+    first = false;
+
+    out << R"({"name":")";
+    switch (event.type_)
+    {
+    case trace_event_type::task_begin:
+    case trace_event_type::task_end:
+      out << "group " << event.group_ << R"(","cat":"task)";
+      break;
+    case trace_event_type::park:
+    case trace_event_type::unpark:
+      out << R"(park","cat":"idle)";
+      break;
+    case trace_event_type::submit:
+      out << R"(submit","cat":"queue)";
+      break;
+    case trace_event_type::steal:
+      out << R"(steal","cat":"queue)";
+      break;
+    default:
+      break;
+    }
+    out << R"(","ph":")" << get_phase(event.type_) << R"(","ts":)";
+    write_timestamp(out, event.timestamp_);
+    out << R"(,"pid":0,"tid":)" << event.worker_;
+    if (get_phase(event.type_) == 'i')
+    {
+      out << R"(,"s":"t","args":{"group":)" << event.group_ << '}';
+    }
+    out << '}';
+  }
+
+  for (auto worker : workers)
+  {
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << R"({"name":"thread_name","ph":"M","pid":0,"tid":)" << worker << R"(,"args":{"name":"worker )" << worker
+        << R"("}})";
+  }
+  out << "\n]}\n";
+}
+
+} // namespace ouly
@@ -0,0 +1,98 @@
+#include "nanobench.h"
+#include "ouly/scheduler/detail/coro_frame_allocator.hpp"
+#include "ouly/scheduler/task.hpp"
+#include <new>
+#include <vector>
+
+// NOLINTBEGIN
+namespace
+{
+ouly::co_task<uint32_t> leaf(uint32_t v)
+{
+  co_return v + 1;
+}
+
+template <typename Allocate, typename Deallocate>
+void bench_frames(ankerl::nanobench::Bench& bench, std::string const& name, uint32_t nbatch, Allocate&& allocate,
+                  Deallocate&& deallocate)
+{
+  // A typical co_task frame, and a window of live frames so the allocator cannot only recycle the last freed block
+  constexpr std::size_t frame_size = 200;
+  constexpr uint32_t    window     = 64;
+  std::vector<void*>    live(window);
+
+  bench.run(name,
+            [&]
+            {
+              for (uint32_t i = 0; i < nbatch; ++i)
+              {
+                void* frame = allocate(frame_size);
+                ankerl::nanobench::doNotOptimizeAway(frame);
+                deallocate(frame, frame_size);
+              }
+            });
+
+  bench.run(name + ", 64 live frames",
+            [&]
+            {
+              for (uint32_t i = 0; i < nbatch; i += window)
+              {
+                for (auto& frame : live)
+                {
+                  frame = allocate(frame_size);
+                }
+                ankerl::nanobench::doNotOptimizeAway(live.data());
+                for (auto* frame : live)
+                {
+                  deallocate(frame, frame_size);
+                }
+              }
+            });
+}
+} // namespace
+
+void bench_coro_frame_allocation()
+{
+  constexpr uint32_t       nbatch = 128000;
+  ankerl::nanobench::Bench bench;
+  bench.title("coroutine frame allocation");
+  bench.output(&std::cout);
+  bench.minEpochIterations(10);
+  bench.batch(nbatch);
+
+  bench_frames(
+   bench, "global operator new", nbatch,
+   [](std::size_t size)
+   {
+     return ::operator new(size);
+   },
+   [](void* frame, std::size_t size)
+   {
+     ::operator delete(frame, size);
+   });
+
+  bench_frames(
+   bench, "frame pool", nbatch,
+   [](std::size_t size)
+   {
+     return ouly::detail::allocate_coro_frame(size);
+   },
+   [](void* frame, std::size_t size)
+   {
+     ouly::detail::deallocate_coro_frame(frame, size);
+   });
+
+  bench.run("co_task create, resume, destroy",
+            [&]
+            {
+              uint32_t sum = 0;
+              for (uint32_t i = 0; i < nbatch; ++i)
+              {
+                auto task = leaf(i);
+                task.resume();
+                sum += task.result();
+              }
+              ankerl::nanobench::doNotOptimizeAway(sum);
+            });
+}
+// NOLINTEND
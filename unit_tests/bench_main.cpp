@@ -79,6 +79,9 @@ void bench_arena(uint32_t size, std::string_view name)
                           });
 }
 
+void bench_coro_frame_allocation();
+void bench_scheduler();
+
 int main(int argc, char* argv[])
 {
   constexpr uint32_t size = 256 * 256;
@@ -98,6 +101,9 @@ int main(int argc, char* argv[])
   bench_arena<ouly::strat::best_fit_v2<ouly::cfg::bsearch_min1>>(size, "bf-v2-min1");
   bench_arena<ouly::strat::best_fit_v2<ouly::cfg::bsearch_min2>>(size, "bf-v2-min2");
 
+  bench_coro_frame_allocation();
+  bench_scheduler();
+
   return 0;
 }
 // NOLINTEND
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include "nanobench.h"
+#include "ouly/scheduler/parallel_for.hpp"
+#include "ouly/scheduler/parallel_sort.hpp"
+#include "ouly/scheduler/scheduler.hpp"
+#include "ouly/scheduler/switch_to.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <random>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+// NOLINTBEGIN
+namespace
+{
+auto get_max_workers() -> uint32_t
+{
+  return std::max(std::thread::hardware_concurrency(), 2U);
+}
+
+void wait_for(ouly::scheduler& s, std::atomic_uint32_t const& done, uint32_t count)
+{
+  while (done.load(std::memory_order_acquire) != count)
+  {
+    s.busy_work(ouly::main_worker_id);
+  }
+}
+
+void bench_submit(uint32_t workers)
+{
+  constexpr uint32_t       nbatch = 100000;
+  ankerl::nanobench::Bench bench;
+  bench.title("submit throughput, " + std::to_string(workers) + " workers");
+  bench.output(&std::cout);
+  bench.minEpochIterations(5);
+  bench.batch(nbatch);
+
+  for (auto mode : {ouly::work_queue_mode::shared_queues, ouly::work_queue_mode::work_stealing})
+  {
+    auto mode_name = std::string(mode == ouly::work_queue_mode::shared_queues ? "shared queues" : "work stealing");
+
+    ouly::scheduler_options options;
+    options.queue_mode = mode;
+    ouly::scheduler scheduler(options);
+    scheduler.create_group(ouly::default_workgroup_id, 0, workers);
+    // A group the main thread is not part of, submits go through the shared queues
+    auto remote = scheduler.create_group(1, workers - 1);
+    scheduler.begin_execution();
+
+    std::atomic_uint32_t done = 0;
+    auto                 task = [&done](ouly::worker_context const&)
+    {
+      done.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    bench.run("single producer, own group, " + mode_name,
+              [&]
+              {
+                done.store(0);
+                for (uint32_t i = 0; i < nbatch; ++i)
+                {
+                  scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, task);
+                }
+                wait_for(scheduler, done, nbatch);
+              });
+
+    bench.run("single producer, other group, " + mode_name,
+              [&]
+              {
+                done.store(0);
+                for (uint32_t i = 0; i < nbatch; ++i)
+                {
+                  scheduler.submit(ouly::main_worker_id, remote, task);
+                }
+                wait_for(scheduler, done, nbatch);
+              });
+
+    // Every worker submits its share of the items from inside a task
+    struct producer_state
+    {
+      std::atomic_uint32_t* done_;
+      uint32_t              per_producer_;
+    };
+    producer_state state{&done, nbatch / workers};
+    bench.run("multi producer, " + mode_name,
+              [&]
+              {
+                done.store(0);
+                for (uint32_t p = 0; p < workers; ++p)
+                {
+                  scheduler.submit(ouly::main_worker_id, ouly::worker_id(p), ouly::default_workgroup_id,
+                                   [&state](ouly::worker_context const& ctx)
+                                   {
+                                     auto* done = state.done_;
+                                     for (uint32_t i = 0; i < state.per_producer_; ++i)
+                                     {
+                                       ouly::async(ctx, ouly::default_workgroup_id,
+                                                   [done](ouly::worker_context const&)
+                                                   {
+                                                     done->fetch_add(1, std::memory_order_relaxed);
+                                                   });
+                                     }
+                                   });
+                }
+                wait_for(scheduler, done, state.per_producer_ * workers);
+              });
+
+    scheduler.end_execution();
+  }
+
+  std::atomic_uint32_t done = 0;
+  bench.batch(nbatch / 100).run("std::async baseline",
+                                [&]
+                                {
+                                  done.store(0);
+                                  std::vector<std::future<void>> futures;
+                                  futures.reserve(nbatch / 100);
+                                  for (uint32_t i = 0; i < nbatch / 100; ++i)
+                                  {
+                                    futures.emplace_back(std::async(std::launch::async,
+                                                                    [&done]
+                                                                    {
+                                                                      done.fetch_add(1, std::memory_order_relaxed);
+                                                                    }));
+                                  }
+                                  for (auto& f : futures)
+                                  {
+                                    f.wait();
+                                  }
+                                });
+}
+
+void bench_empty_task()
+{
+  constexpr uint32_t       nbatch = 100000;
+  ankerl::nanobench::Bench bench;
+  bench.title("empty task overhead");
+  bench.output(&std::cout);
+  bench.minEpochIterations(10);
+  bench.batch(nbatch);
+
+  // Only the main thread, measures submit, dequeue and invoke without any thread handoff
+  for (auto mode : {ouly::work_queue_mode::shared_queues, ouly::work_queue_mode::work_stealing})
+  {
+    ouly::scheduler_options options;
+    options.queue_mode = mode;
+    ouly::scheduler scheduler(options);
+    scheduler.create_group(ouly::default_workgroup_id, 0, 1);
+    scheduler.begin_execution();
+    bench.run(mode == ouly::work_queue_mode::shared_queues ? "submit and run, shared queues"
+                                                           : "submit and run, work stealing",
+              [&]
+              {
+                for (uint32_t i = 0; i < nbatch; ++i)
+                {
+                  scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id,
+                                   [](ouly::worker_context const&) {});
+                  scheduler.busy_work(ouly::main_worker_id);
+                }
+              });
+    scheduler.end_execution();
+  }
+
+  ouly::detail::work_item item = ouly::detail::work_item::pbind(
+   [](ouly::worker_context const&)
+   {
+   },
+   ouly::default_workgroup_id);
+  ouly::worker_context ctx;
+  bench.run("direct work_item call baseline",
+            [&]
+            {
+              for (uint32_t i = 0; i < nbatch; ++i)
+              {
+                item(ctx);
+                ankerl::nanobench::doNotOptimizeAway(item);
+              }
+            });
+}
+
+void bench_parallel_for()
+{
+  constexpr uint32_t element_count = 1U << 22;
+  std::vector<float> a(element_count, 1.0f);
+  std::vector<float> b(element_count, 2.0f);
+
+  auto memory_kernel = [&](int begin, int end)
+  {
+    for (auto i = begin; i < end; ++i)
+    {
+      a[i] += b[i] * 0.5f;
+    }
+  };
+  auto compute_kernel = [&](int begin, int end)
+  {
+    for (auto i = begin; i < end; ++i)
+    {
+      float v = a[i];
+      for (uint32_t k = 0; k < 32; ++k)
+      {
+        v = std::sqrt(v * v + 1.0f) * 0.999f;
+      }
+      a[i] = v;
+    }
+  };
+
+  auto run = [&](std::string const& kernel_name, auto& kernel, uint32_t elements)
+  {
+    ankerl::nanobench::Bench bench;
+    bench.title("parallel_for, " + kernel_name);
+    bench.output(&std::cout);
+    bench.minEpochIterations(5);
+    bench.batch(elements);
+    bench.relative(true);
+
+    bench.run("serial loop",
+              [&]
+              {
+                kernel(0, static_cast<int>(elements));
+              });
+
+    for (uint32_t workers = 1; workers <= get_max_workers(); workers *= 2)
+    {
+      ouly::scheduler scheduler;
+      scheduler.create_group(ouly::default_workgroup_id, 0, workers);
+      scheduler.begin_execution();
+      bench.run("ouly " + std::to_string(workers) + " workers",
+                [&]
+                {
+                  ouly::parallel_for(
+                   [&](int begin, int end, ouly::worker_context const&)
+                   {
+                     kernel(begin, end);
+                   },
+                   ouly::integer_range(0, static_cast<int>(elements)), ouly::default_workgroup_id);
+                });
+      scheduler.end_execution();
+
+      bench.run("std::thread " + std::to_string(workers) + " threads",
+                [&]
+                {
+                  std::vector<std::thread> threads;
+                  auto                     chunk = elements / workers;
+                  for (uint32_t t = 1; t < workers; ++t)
+                  {
+                    threads.emplace_back(
+                     [&, t]
+                     {
+                       kernel(static_cast<int>(t * chunk),
+                              static_cast<int>(t + 1 == workers ? elements : (t + 1) * chunk));
+                     });
+                  }
+                  kernel(0, static_cast<int>(chunk));
+                  for (auto& t : threads)
+                  {
+                    t.join();
+                  }
+                });
+    }
+  };
+
+  run("memory bound", memory_kernel, element_count);
+  run("compute bound", compute_kernel, element_count / 16);
+}
+
+void bench_parallel_sort()
+{
+  constexpr uint32_t    element_count = 1U << 22;
+  std::mt19937_64       gen(7);
+  std::vector<uint64_t> keys(element_count);
+  for (auto& k : keys)
+  {
+    k = gen();
+  }
+  std::vector<uint64_t> data(element_count);
+  std::vector<uint64_t> scratch(element_count);
+
+  ankerl::nanobench::Bench bench;
+  bench.title("parallel_sort, " + std::to_string(element_count) + " keys");
+  bench.output(&std::cout);
+  bench.minEpochIterations(2);
+  bench.batch(element_count);
+  bench.relative(true);
+
+  bench.run("std::sort",
+            [&]
+            {
+              data = keys;
+              std::sort(data.begin(), data.end());
+            });
+  bench.run("std::stable_sort",
+            [&]
+            {
+              data = keys;
+              std::stable_sort(data.begin(), data.end());
+            });
+
+  for (uint32_t workers = 1; workers <= get_max_workers(); workers *= 2)
+  {
+    ouly::scheduler scheduler;
+    scheduler.create_group(ouly::default_workgroup_id, 0, workers);
+    scheduler.begin_execution();
+    bench.run("ouly parallel_sort " + std::to_string(workers) + " workers",
+              [&]
+              {
+                data = keys;
+                ouly::parallel_sort(std::span(data), scratch, std::less<>(), ouly::default_workgroup_id);
+              });
+    bench.run("ouly parallel_stable_sort " + std::to_string(workers) + " workers",
+              [&]
+              {
+                data = keys;
+                ouly::parallel_stable_sort(std::span(data), scratch, std::less<>(), ouly::default_workgroup_id);
+              });
+    scheduler.end_execution();
+  }
+}
+
+ouly::co_task<void> ping_pong(ouly::scheduler& s, ouly::workgroup_id ping, ouly::workgroup_id pong, uint32_t hops)
+{
+  for (uint32_t i = 0; i < hops; ++i)
+  {
+    co_await ouly::switch_to(s, (i & 1) != 0 ? ping : pong);
+  }
+}
+
+void bench_latency()
+{
+  constexpr uint32_t       hops = 10000;
+  ankerl::nanobench::Bench bench;
+  bench.title("latency");
+  bench.output(&std::cout);
+  bench.minEpochIterations(5);
+  bench.batch(hops);
+
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 1);
+  auto ping = scheduler.create_group(1, 1);
+  auto pong = scheduler.create_group(2, 1);
+  scheduler.begin_execution();
+
+  bench.run("coroutine ping-pong between workgroups",
+            [&]
+            {
+              auto task = ping_pong(scheduler, ping, pong, hops);
+              scheduler.submit(ouly::main_worker_id, ping, task);
+              task.sync_wait_result();
+            });
+
+  bench.run("busywork_event wait, remote notify",
+            [&]
+            {
+              for (uint32_t i = 0; i < hops; ++i)
+              {
+                ouly::busywork_event event;
+                scheduler.submit(ouly::main_worker_id, ping,
+                                 [&event](ouly::worker_context const&)
+                                 {
+                                   event.notify();
+                                 });
+                event.wait(ouly::main_worker_id, scheduler);
+              }
+            });
+  scheduler.end_execution();
+
+  std::binary_semaphore to_pong{0};
+  std::binary_semaphore to_ping{0};
+  std::atomic_bool      quit = false;
+  std::thread           pong_thread(
+   [&]
+   {
+     while (true)
+     {
+       to_pong.acquire();
+       if (quit.load())
+       {
+         return;
+       }
+       to_ping.release();
+     }
+   });
+  bench.run("std::thread semaphore ping-pong baseline",
+            [&]
+            {
+              for (uint32_t i = 0; i < hops; i += 2)
+              {
+                to_pong.release();
+                to_ping.acquire();
+              }
+            });
+  quit = true;
+  to_pong.release();
+  pong_thread.join();
+}
+} // namespace
+
+void bench_scheduler()
+{
+  bench_empty_task();
+  bench_submit(get_max_workers());
+  bench_parallel_for();
+  bench_parallel_sort();
+  bench_latency();
+}
+// NOLINTEND
@@ -1,9 +1,29 @@
 #include "catch2/catch_all.hpp"
+#include "ouly/scheduler/async_sync.hpp"
+#include "ouly/scheduler/io_service.hpp"
 #include "ouly/scheduler/parallel_for.hpp"
+#include "ouly/scheduler/parallel_reduce.hpp"
+#include "ouly/scheduler/parallel_scan.hpp"
+#include "ouly/scheduler/parallel_sort.hpp"
+#include "ouly/scheduler/pipeline.hpp"
 #include "ouly/scheduler/scheduler.hpp"
+#include "ouly/scheduler/switch_to.hpp"
+#include "ouly/scheduler/task_graph.hpp"
+#include "ouly/scheduler/task_group.hpp"
+#include "ouly/scheduler/when_all.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <numeric>
+#include <random>
 #include <ranges>
+#include <sstream>
 #include <string>
+#include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 // NOLINTBEGIN
 TEST_CASE("scheduler: Construction")
@@ -98,6 +118,34 @@ TEST_CASE("scheduler: Range ParallelFor")
   scheduler.end_execution();
 }
 
+TEST_CASE("scheduler: ParallelFor batch count")
+{
+  static_assert(ouly::detail::get_work_count(4, 16, 10000) == 64);
+  static_assert(ouly::detail::get_work_count(4, 16, 40) == 40);
+
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::workgroup_id(0), 0, 16);
+  scheduler.begin_execution();
+
+  // batches_per_worker batches for each of the 16 workers, fewer when there are fewer elements
+  for (auto [count, expected] : {std::pair{10000, 64}, std::pair{40, 40}})
+  {
+    std::atomic_int batches  = 0;
+    std::atomic_int elements = 0;
+    ouly::parallel_for(
+     [&batches, &elements](int a, int b, ouly::worker_context const&)
+     {
+       batches.fetch_add(1);
+       elements.fetch_add(b - a);
+     },
+     ouly::integer_range(0, count), ouly::default_workgroup_id);
+    CHECK(batches.load() == expected);
+    CHECK(elements.load() == count);
+  }
+
+  scheduler.end_execution();
+}
+
 TEST_CASE("scheduler: Simplest ParallelFor")
 {
   ouly::scheduler scheduler;
@@ -291,4 +339,1800 @@ TEST_CASE("scheduler: Test submit_to")
     REQUIRE(collection[i] == i);
   }
 }
+
+TEST_CASE("scheduler: work_stealing_deque owner and thief order")
+{
+  ouly::detail::work_stealing_deque<uint32_t> deque;
+  deque.reset(6);
+
+  for (uint32_t i = 0; i < 8; ++i)
+    REQUIRE(deque.try_push(i));
+  REQUIRE(!deque.try_push(8));
+  REQUIRE(deque.size() == 8);
+
+  uint32_t value = 0;
+  REQUIRE(deque.try_steal(value));
+  REQUIRE(value == 0);
+  REQUIRE(deque.try_pop(value));
+  REQUIRE(value == 7);
+  REQUIRE(deque.try_steal(value));
+  REQUIRE(value == 1);
+
+  while (deque.try_pop(value))
+    ;
+  REQUIRE(deque.empty());
+  REQUIRE(!deque.try_steal(value));
+}
+
+TEST_CASE("scheduler: mpsc_mailbox order and node reuse")
+{
+  using mailbox = ouly::detail::mpsc_mailbox<uint64_t>;
+  using pool    = ouly::detail::mailbox_node_pool<uint64_t>;
+
+  mailbox box;
+  pool    nodes;
+  REQUIRE(box.empty());
+  REQUIRE(box.try_pop() == nullptr);
+
+  for (uint64_t i = 0; i < 3; ++i)
+  {
+    auto* n  = nodes.acquire(0);
+    n->item_ = i;
+    box.push(n);
+  }
+  REQUIRE(!box.empty());
+  for (uint64_t i = 0; i < 3; ++i)
+  {
+    auto* n = box.try_pop();
+    REQUIRE(n != nullptr);
+    REQUIRE(n->item_ == i);
+    nodes.release(n);
+  }
+  REQUIRE(box.empty());
+  REQUIRE(box.try_pop() == nullptr);
+
+  // Released nodes are handed out again
+  auto* first = nodes.acquire(0);
+  REQUIRE(first->owner_ == 0);
+  nodes.release(first);
+
+  constexpr uint32_t producers    = 4;
+  constexpr uint32_t per_producer = 20000;
+
+  std::array<pool, producers> pools;
+  std::vector<std::thread>    threads;
+  for (uint32_t p = 0; p < producers; ++p)
+  {
+    threads.emplace_back(
+     [&, p]
+     {
+       for (uint32_t i = 0; i < per_producer; ++i)
+       {
+         auto* n  = pools[p].acquire(p);
+         n->item_ = (uint64_t{p} << 32U) | i;
+         box.push(n);
+       }
+     });
+  }
+
+  std::array<uint32_t, producers> next{};
+  uint32_t                        received = 0;
+  bool                            ordered  = true;
+  while (received < producers * per_producer)
+  {
+    auto* n = box.try_pop();
+    if (n == nullptr)
+    {
+      continue;
+    }
+    auto p = static_cast<uint32_t>(n->item_ >> 32U);
+    ordered &= p == n->owner_ && static_cast<uint32_t>(n->item_) == next[p]++;
+    pools[n->owner_].release(n);
+    ++received;
+  }
+  for (auto& t : threads)
+  {
+    t.join();
+  }
+  CHECK(ordered);
+  CHECK(box.empty());
+  CHECK(box.try_pop() == nullptr);
+}
+
+TEST_CASE("scheduler: Submit to a worker from an external thread")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::workgroup_id(0), 0, 4);
+  scheduler.begin_execution();
+
+  // The external thread names the main thread as source, its nodes come from the shared pool
+  struct
+  {
+    std::atomic_uint32_t received     = 0;
+    std::atomic_uint32_t wrong_worker = 0;
+  } state;
+  constexpr uint32_t count = 1000;
+  auto               post  = [&scheduler, &state]()
+  {
+    for (uint32_t i = 0; i < count; ++i)
+      scheduler.submit(ouly::main_worker_id, ouly::worker_id(2), ouly::default_workgroup_id,
+                       [&state](ouly::worker_context const& ctx)
+                       {
+                         if (ctx.get_worker() != ouly::worker_id(2))
+                         {
+                           state.wrong_worker.fetch_add(1);
+                         }
+                         state.received.fetch_add(1);
+                       });
+  };
+  std::thread external(post);
+  post();
+  external.join();
+
+  scheduler.end_execution();
+  CHECK(state.received.load() == 2 * count);
+  CHECK(state.wrong_worker.load() == 0);
+}
+
+void spawn_tree(ouly::worker_context const& ctx, std::atomic_uint32_t& counter, uint32_t depth)
+{
+  counter.fetch_add(1);
+  if (depth == 0)
+    return;
+  for (uint32_t i = 0; i < 2; ++i)
+    ouly::async(ctx, ctx.get_workgroup(),
+                [&counter, depth](ouly::worker_context const& wc)
+                {
+                  spawn_tree(wc, counter, depth - 1);
+                });
+}
+
+TEST_CASE("scheduler: Work stealing mode")
+{
+  ouly::scheduler_options options;
+  options.queue_mode     = ouly::work_queue_mode::work_stealing;
+  options.deque_capacity = 64;
+
+  ouly::scheduler scheduler(options);
+  scheduler.create_group(ouly::workgroup_id(0), 0, 8);
+  scheduler.create_group(ouly::workgroup_id(1), 8, 2);
+
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t counter = 0;
+  std::atomic_uint32_t other   = 0;
+  constexpr uint32_t   depth   = 12;
+  ouly::async(ouly::worker_context::get(ouly::default_workgroup_id), ouly::default_workgroup_id,
+              [&counter](ouly::worker_context const& wc)
+              {
+                spawn_tree(wc, counter, depth);
+              });
+  for (uint32_t i = 0; i < 1024; ++i)
+    ouly::async(ouly::worker_context::get(ouly::default_workgroup_id), ouly::workgroup_id(1),
+                [&other](ouly::worker_context const&)
+                {
+                  other.fetch_add(1);
+                });
+
+  std::atomic_int64_t sum = 0;
+  ouly::parallel_for(
+   [&sum](int a, int b, ouly::worker_context const&)
+   {
+     for (int i = a; i < b; ++i)
+       sum += i;
+   },
+   ouly::integer_range(0, 4096), ouly::default_workgroup_id);
+  REQUIRE(sum.load() == 4095 * 4096 / 2);
+
+  scheduler.end_execution();
+
+  REQUIRE(counter.load() == (1U << (depth + 1)) - 1);
+  REQUIRE(other.load() == 1024);
+}
+
+TEST_CASE("scheduler: Local ring spill and steal")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::workgroup_id(0), 0, 4);
+  scheduler.create_group(ouly::workgroup_id(1), 2, 4);
+
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t counter = 0;
+  std::atomic_uint32_t fanout  = 0;
+  constexpr uint32_t   depth   = 10;
+  ouly::async(ouly::worker_context::get(ouly::default_workgroup_id), ouly::workgroup_id(1),
+              [&counter, &fanout](ouly::worker_context const& wc)
+              {
+                // Overflow the submitting worker's local ring into the shared queues
+                for (uint32_t i = 0; i < 4 * ouly::detail::max_local_work_item; ++i)
+                  ouly::async(wc, wc.get_workgroup(),
+                              [&fanout](ouly::worker_context const&)
+                              {
+                                fanout.fetch_add(1);
+                              });
+                spawn_tree(wc, counter, depth);
+              });
+
+  scheduler.end_execution();
+
+  REQUIRE(counter.load() == (1U << (depth + 1)) - 1);
+  REQUIRE(fanout.load() == 4 * ouly::detail::max_local_work_item);
+}
+
+TEST_CASE("scheduler: Submit with the id of another worker")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::workgroup_id(0), 0, 4);
+  scheduler.begin_execution();
+
+  // Only worker 1 may push into its own ring, the others naming it go through the shared queues
+  std::atomic_uint32_t counter = 0;
+  constexpr uint32_t   count   = 4 * ouly::detail::max_local_work_item;
+  auto                 flood   = [&scheduler, &counter]()
+  {
+    for (uint32_t i = 0; i < count; ++i)
+      scheduler.submit(ouly::worker_id(1), ouly::default_workgroup_id,
+                       [&counter](ouly::worker_context const&)
+                       {
+                         counter.fetch_add(1);
+                       });
+  };
+  std::thread external(flood);
+  scheduler.submit(ouly::main_worker_id, ouly::worker_id(1), ouly::default_workgroup_id,
+                   [&flood](ouly::worker_context const&)
+                   {
+                     flood();
+                   });
+  flood();
+  external.join();
+
+  scheduler.end_execution();
+  REQUIRE(counter.load() == 3 * count);
+}
+
+TEST_CASE("scheduler: Idle policy spin then park")
+{
+  ouly::scheduler_options options;
+  options.idle.spin_iterations  = 256;
+  options.idle.yield_iterations = 16;
+
+  ouly::scheduler scheduler(options);
+  scheduler.create_group(ouly::workgroup_id(0), 0, 4);
+
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t counter = 0;
+  for (uint32_t burst = 0; burst < 16; ++burst)
+  {
+    for (uint32_t i = 0; i < 64; ++i)
+      ouly::async(ouly::worker_context::get(ouly::default_workgroup_id), ouly::default_workgroup_id,
+                  [&counter](ouly::worker_context const&)
+                  {
+                    counter.fetch_add(1);
+                  });
+    while (counter.load() < (burst + 1) * 64)
+      scheduler.busy_work(ouly::main_worker_id);
+  }
+
+  scheduler.end_execution();
+
+  REQUIRE(counter.load() == 16 * 64);
+
+  ouly::worker_idle_stats total;
+  for (uint32_t w = 1; w < scheduler.get_worker_count(); ++w)
+  {
+    auto stats = scheduler.get_idle_stats(ouly::worker_id(w));
+    REQUIRE(stats.spin_hits <= stats.spin_polls);
+    REQUIRE(stats.yield_hits <= stats.yield_polls);
+    total.spin_polls += stats.spin_polls;
+    total.parks += stats.parks;
+  }
+  REQUIRE(total.spin_polls > 0);
+}
+
+TEST_CASE("scheduler: Batched submission")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::workgroup_id(0), 0, 8);
+  scheduler.create_group(ouly::workgroup_id(1), 8, 3);
+
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t                 counter = 0;
+  std::vector<ouly::detail::work_item> items;
+  for (uint32_t i = 0; i < 1000; ++i)
+    items.emplace_back(ouly::detail::work_item::pbind(
+     [&counter, i](ouly::worker_context const&)
+     {
+       counter.fetch_add(i);
+     },
+     ouly::workgroup_id(1)));
+  scheduler.submit_batch(ouly::main_worker_id, ouly::workgroup_id(1), items);
+
+  std::atomic_uint32_t generated = 0;
+  scheduler.submit_batch(ouly::main_worker_id, ouly::default_workgroup_id, 10000,
+                         [&generated](uint32_t)
+                         {
+                           return ouly::detail::work_item::pbind(
+                            [&generated](ouly::worker_context const&)
+                            {
+                              generated.fetch_add(1);
+                            },
+                            ouly::default_workgroup_id);
+                         });
+
+  // Fewer items than sleeping workers
+  std::atomic_uint32_t few = 0;
+  scheduler.submit_batch(ouly::main_worker_id, ouly::workgroup_id(1), 2,
+                         [&few](uint32_t)
+                         {
+                           return ouly::detail::work_item::pbind(
+                            [&few](ouly::worker_context const&)
+                            {
+                              few.fetch_add(1);
+                            },
+                            ouly::workgroup_id(1));
+                         });
+
+  scheduler.end_execution();
+
+  REQUIRE(counter.load() == 999 * 500);
+  REQUIRE(generated.load() == 10000);
+  REQUIRE(few.load() == 2);
+}
+
+TEST_CASE("scheduler: Batched submission from a worker")
+{
+  ouly::scheduler_options options;
+  options.queue_mode     = ouly::work_queue_mode::work_stealing;
+  options.deque_capacity = 64;
+
+  ouly::scheduler scheduler(options);
+  auto            moving = ouly::workgroup_id(1);
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  scheduler.create_group(moving, 4, 2);
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t counter = 0;
+  auto                 make    = [&counter](ouly::workgroup_id group)
+  {
+    return [&counter, group](uint32_t)
+    {
+      return ouly::detail::work_item::pbind(
+       [&counter](ouly::worker_context const&)
+       {
+         counter.fetch_add(1);
+       },
+       group);
+    };
+  };
+
+  // The main worker keeps what fits in its deque, the rest spills into the shared queues
+  scheduler.submit_batch(ouly::main_worker_id, ouly::default_workgroup_id, 200, make(ouly::default_workgroup_id));
+  while (counter.load() < 200)
+  {
+    scheduler.busy_work(ouly::main_worker_id);
+  }
+  auto stats = scheduler.collect_stats().get_total();
+  CHECK(stats.local_pops + stats.stolen_pops == 64);
+  CHECK(stats.shared_pops == 136);
+
+  // A thread that is not a worker waits for resize_group to finish rebuilding the queues
+  std::thread external(
+   [&]
+   {
+     for (uint32_t i = 0; i < 50; ++i)
+     {
+       scheduler.submit_batch(ouly::main_worker_id, moving, 20, make(moving));
+     }
+   });
+  for (uint32_t round = 0; round < 20; ++round)
+  {
+    scheduler.resize_group(moving, 4, 1 + (round % 2));
+  }
+  external.join();
+  while (counter.load() < 1200)
+  {
+    scheduler.busy_work(ouly::main_worker_id);
+  }
+
+  scheduler.end_execution();
+  REQUIRE(counter.load() == 1200);
+}
+
+TEST_CASE("scheduler: Task graph replay")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::workgroup_id(0), 0, 8);
+  scheduler.create_group(ouly::workgroup_id(1), 4, 4);
+
+  struct state
+  {
+    std::atomic_uint32_t     sequence = 0;
+    std::array<uint32_t, 64> order{};
+  } st;
+
+  ouly::task_graph graph;
+  // root -> 60 wide nodes -> join -> tail, wide nodes alternate between groups
+  auto root = graph.add_node(ouly::default_workgroup_id,
+                             [&st](ouly::worker_context const&)
+                             {
+                               st.order[0] = st.sequence++;
+                             });
+  auto join = graph.add_node(ouly::workgroup_id(1),
+                             [&st](ouly::worker_context const&)
+                             {
+                               st.order[61] = st.sequence++;
+                             });
+  auto tail = graph.add_node(ouly::default_workgroup_id,
+                             [&st](ouly::worker_context const&)
+                             {
+                               st.order[62] = st.sequence++;
+                             });
+  for (uint32_t i = 1; i <= 60; ++i)
+  {
+    auto n = graph.add_node(ouly::workgroup_id(i % 2),
+                            [&st, i](ouly::worker_context const&)
+                            {
+                              st.order[i] = st.sequence++;
+                            });
+    graph.add_edge(root, n);
+    graph.add_edge(n, join);
+  }
+  graph.add_edge(join, tail);
+  REQUIRE(graph.finalize());
+  REQUIRE(graph.get_node_count() == 63);
+
+  scheduler.begin_execution();
+  for (uint32_t frame = 0; frame < 100; ++frame)
+  {
+    st.sequence = 0;
+    graph.run(ouly::worker_context::get(ouly::default_workgroup_id));
+    REQUIRE(st.sequence.load() == 63);
+    REQUIRE(st.order[0] == 0);
+    for (uint32_t i = 1; i <= 60; ++i)
+    {
+      REQUIRE(st.order[i] > st.order[0]);
+      REQUIRE(st.order[i] < st.order[61]);
+    }
+    REQUIRE(st.order[62] == 62);
+  }
+
+  ouly::task_graph empty;
+  REQUIRE(empty.finalize());
+  empty.run(ouly::worker_context::get(ouly::default_workgroup_id));
+
+  // A root next to a 2 node cycle, the cycle is never reached from the root
+  ouly::task_graph cyclic;
+  auto             noop   = [](ouly::worker_context const&) {};
+  auto             start  = cyclic.add_node(ouly::default_workgroup_id, noop);
+  auto             first  = cyclic.add_node(ouly::default_workgroup_id, noop);
+  auto             second = cyclic.add_node(ouly::default_workgroup_id, noop);
+  cyclic.add_edge(start, first);
+  cyclic.add_edge(first, second);
+  cyclic.add_edge(second, first);
+  REQUIRE(!cyclic.finalize());
+
+  scheduler.end_execution();
+}
+
+ouly::co_task<uint32_t> hop_groups(ouly::scheduler& s, ouly::workgroup_id io, ouly::worker_id target)
+{
+  uint32_t checks = 0;
+  for (uint32_t i = 0; i < 8; ++i)
+  {
+    co_await ouly::switch_to(s, io);
+    auto id = ouly::worker_id::get().get_index();
+    checks += (id >= s.get_worker_start_idx(io) && id < s.get_worker_start_idx(io) + s.get_worker_count(io)) ? 1 : 0;
+
+    co_await ouly::switch_to(s, ouly::default_workgroup_id);
+    checks += ouly::worker_id::get().get_index() < s.get_worker_count(ouly::default_workgroup_id) ? 1 : 0;
+
+    co_await ouly::switch_to(s, target);
+    checks += ouly::worker_id::get() == target ? 1 : 0;
+  }
+  co_return checks;
+}
+
+TEST_CASE("scheduler: Coroutine switch_to")
+{
+  ouly::scheduler scheduler;
+  auto            io = ouly::workgroup_id(1);
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  scheduler.create_group(io, 4, 2);
+
+  scheduler.begin_execution();
+
+  auto task = hop_groups(scheduler, io, ouly::worker_id(5));
+  scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, task);
+  REQUIRE(task.sync_wait_result() == 24);
+
+  scheduler.end_execution();
+}
+
+ouly::co_task<uint32_t> tree_sum(uint32_t depth)
+{
+  if (depth == 0)
+  {
+    co_return 1;
+  }
+  std::vector<ouly::co_task<uint32_t>> children;
+  children.reserve(3);
+  for (uint32_t i = 0; i < 3; ++i)
+  {
+    children.emplace_back(tree_sum(depth - 1));
+  }
+  co_await ouly::when_all(std::span(children));
+  uint32_t sum = 1;
+  for (auto& child : children)
+  {
+    sum += child.result();
+  }
+  co_return sum;
+}
+
+ouly::co_task<uint32_t> pair_sum(uint32_t a, uint32_t b)
+{
+  auto left  = tree_sum(a);
+  auto right = tree_sum(b);
+  co_await ouly::when_all(left, right);
+  co_return left.result() + right.result();
+}
+
+ouly::co_task<uint32_t> wait_flag(std::atomic_bool& flag)
+{
+  while (!flag.load())
+  {
+    std::this_thread::yield();
+  }
+  co_return 7;
+}
+
+ouly::co_task<uint32_t> immediate(uint32_t value)
+{
+  co_return value;
+}
+
+ouly::co_task<uint32_t> first_of(std::atomic_bool& flag)
+{
+  auto slow  = wait_flag(flag);
+  auto fast  = immediate(5);
+  auto index = co_await ouly::when_any(slow, fast);
+  flag       = true;
+  // The slow child is detached and can still be awaited on its own
+  auto late = co_await slow;
+  co_return (index * 100) + fast.result() + late;
+}
+
+TEST_CASE("scheduler: Coroutine when_all and when_any")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+
+  scheduler.begin_execution();
+
+  for (uint32_t repeat = 0; repeat < 16; ++repeat)
+  {
+    auto task = pair_sum(4, 2);
+    scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, task);
+    // 3-ary trees of depth 4 and 2
+    REQUIRE(task.sync_wait_result() == 121 + 13);
+  }
+
+  std::atomic_bool flag = false;
+  auto             any  = first_of(flag);
+  scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, any);
+  REQUIRE(any.sync_wait_result() == 112);
+
+  scheduler.end_execution();
+}
+
+TEST_CASE("scheduler: Coroutine frame pool")
+{
+  auto* frame = ouly::detail::allocate_coro_frame(200);
+  REQUIRE(frame != nullptr);
+  ouly::detail::deallocate_coro_frame(frame, 200);
+  // Same size class is served from the local free list
+  auto* reused = ouly::detail::allocate_coro_frame(180);
+  CHECK(reused == frame);
+
+  // Freed on another thread, handed back to the owner on its next allocation
+  std::thread other(
+   [reused]()
+   {
+     ouly::detail::deallocate_coro_frame(reused, 180);
+   });
+  other.join();
+  auto* reclaimed = ouly::detail::allocate_coro_frame(200);
+  CHECK(reclaimed == frame);
+  ouly::detail::deallocate_coro_frame(reclaimed, 200);
+
+  auto* large = ouly::detail::allocate_coro_frame(ouly::detail::max_pooled_frame_size);
+  REQUIRE(large != nullptr);
+  ouly::detail::deallocate_coro_frame(large, ouly::detail::max_pooled_frame_size);
+
+  // Frames created on the main thread and destroyed by workers
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  scheduler.begin_execution();
+  for (uint32_t repeat = 0; repeat < 8; ++repeat)
+  {
+    auto task = pair_sum(3, 3);
+    scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, task);
+    REQUIRE(task.sync_wait_result() == 80);
+  }
+  scheduler.end_execution();
+}
+
+struct small_batches
+{
+  static constexpr uint32_t fixed_batch_size             = 7;
+  static constexpr uint32_t parallel_execution_threshold = 8;
+};
+
+TEST_CASE("scheduler: Parallel reduce and scan")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 8);
+  scheduler.begin_execution();
+
+  constexpr uint32_t   nb_elements = 10007;
+  std::vector<int64_t> list(nb_elements);
+  for (uint32_t i = 0; i < nb_elements; ++i)
+  {
+    list[i] = std::rand() % 1000;
+  }
+
+  SECTION("reduce")
+  {
+    auto expected = std::accumulate(list.begin(), list.end(), int64_t{5});
+    CHECK(ouly::parallel_reduce(std::span(list), int64_t{5}, std::plus<>(), ouly::default_workgroup_id) == expected);
+    CHECK(ouly::parallel_reduce(std::span(list), int64_t{5}, std::plus<>(), ouly::default_workgroup_id,
+                                small_batches{}) == expected);
+    // Serial path
+    CHECK(ouly::parallel_reduce(std::span(list).first(4), int64_t{0}, std::plus<>(), ouly::default_workgroup_id) ==
+          list[0] + list[1] + list[2] + list[3]);
+
+    auto squares = ouly::parallel_transform_reduce(
+     ouly::integer_range<uint64_t>(0, 5000), uint64_t{0}, std::plus<>(),
+     [](uint64_t i)
+     {
+       return i * i;
+     },
+     ouly::default_workgroup_id);
+    CHECK(squares == uint64_t{4999} * 5000 * 9999 / 6);
+
+    // Not commutative, batch order must be preserved
+    std::vector<std::string> words(300);
+    std::string              concat;
+    for (uint32_t i = 0; i < words.size(); ++i)
+    {
+      words[i] = std::to_string(i);
+      concat += words[i];
+    }
+    CHECK(ouly::parallel_reduce(std::span(words), std::string(), std::plus<>(), ouly::default_workgroup_id,
+                                small_batches{}) == concat);
+  }
+
+  SECTION("scan")
+  {
+    std::vector<int64_t> expected(nb_elements);
+    std::vector<int64_t> result(nb_elements);
+
+    std::inclusive_scan(list.begin(), list.end(), expected.begin());
+    ouly::parallel_inclusive_scan(std::span(list), result.begin(), std::plus<>(), ouly::default_workgroup_id);
+    CHECK(result == expected);
+
+    std::exclusive_scan(list.begin(), list.end(), expected.begin(), int64_t{3});
+    ouly::parallel_exclusive_scan(std::span(list), result.begin(), int64_t{3}, std::plus<>(),
+                                  ouly::default_workgroup_id, small_batches{});
+    CHECK(result == expected);
+
+    // In place
+    std::inclusive_scan(list.begin(), list.end(), expected.begin());
+    ouly::parallel_inclusive_scan(std::span(list), list.begin(), std::plus<>(), ouly::default_workgroup_id,
+                                  small_batches{});
+    CHECK(list == expected);
+  }
+
+  scheduler.end_execution();
+}
+
+struct adaptive_traits
+{
+  static constexpr bool adaptive_splitting = true;
+};
+
+TEST_CASE("scheduler: Adaptive ParallelFor")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 8);
+  scheduler.begin_execution();
+
+  constexpr uint32_t    nb_elements = 20000;
+  std::vector<uint32_t> hits(nb_elements, 0);
+  std::atomic_uint64_t  sum = 0;
+
+  // Uneven cost, the first elements are much more expensive
+  ouly::parallel_for(
+   [&](uint32_t a, uint32_t b, ouly::worker_context const&)
+   {
+     uint64_t local = 0;
+     for (uint32_t i = a; i < b; ++i)
+     {
+       hits[i]++;
+       uint32_t spins = i < 500 ? 2000 : 1;
+       for (uint32_t s = 0; s < spins; ++s)
+       {
+         local += (i ^ s) & 1U;
+       }
+       local += i;
+     }
+     sum += local;
+   },
+   ouly::integer_range<uint32_t>(0, nb_elements), ouly::default_workgroup_id, adaptive_traits{});
+
+  CHECK(std::ranges::all_of(hits,
+                            [](uint32_t h)
+                            {
+                              return h == 1;
+                            }));
+  CHECK(sum.load() > uint64_t{nb_elements - 1} * nb_elements / 2);
+
+  std::vector<int> values(nb_elements, 1);
+  ouly::parallel_for(
+   [](int& v, ouly::worker_context const&)
+   {
+     v *= 3;
+   },
+   std::span(values), ouly::default_workgroup_id, adaptive_traits{});
+  CHECK(std::accumulate(values.begin(), values.end(), 0) == 3 * static_cast<int>(nb_elements));
+
+  scheduler.end_execution();
+}
+
+namespace
+{
+void write_sysfs(std::filesystem::path const& path, std::string const& content)
+{
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream(path) << content << "\n";
+}
+} // namespace
+
+TEST_CASE("scheduler: Cpu topology")
+{
+  // 2 nodes, 2 cores per node, 2 threads per core, one L3 per node
+  auto root = std::filesystem::temp_directory_path() / "ouly_sysfs_test";
+  std::filesystem::remove_all(root);
+  write_sysfs(root / "cpu/online", "0-7");
+  write_sysfs(root / "node/online", "0-1");
+  write_sysfs(root / "node/node0/cpulist", "0-1,4-5");
+  write_sysfs(root / "node/node1/cpulist", "2-3,6-7");
+  for (uint32_t cpu = 0; cpu < 8; ++cpu)
+  {
+    auto     path    = root / "cpu" / ("cpu" + std::to_string(cpu));
+    uint32_t package = (cpu % 4) / 2;
+    write_sysfs(path / "topology/physical_package_id", std::to_string(package));
+    write_sysfs(path / "topology/core_id", std::to_string(cpu % 2));
+    write_sysfs(path / "cache/index0/level", "1");
+    write_sysfs(path / "cache/index0/type", "Data");
+    write_sysfs(path / "cache/index1/level", "3");
+    write_sysfs(path / "cache/index1/type", "Unified");
+    write_sysfs(path / "cache/index1/shared_cpu_list", package == 0 ? "0-1,4-5" : "2-3,6-7");
+  }
+
+  auto topology = ouly::cpu_topology::detect(root.string());
+  std::filesystem::remove_all(root);
+
+  REQUIRE(topology.get_cpus().size() == 8);
+  CHECK(topology.get_node_count() == 2);
+  CHECK(topology.get_core_count() == 4);
+  CHECK(topology.get_l3_count() == 2);
+  CHECK(topology.find(5)->core_ == topology.find(1)->core_);
+  CHECK(topology.find(6)->node_ == 1);
+  CHECK(topology.find(6)->l3_ == topology.find(3)->l3_);
+  CHECK(topology.find(9) == nullptr);
+
+  CHECK(topology.get_physical_cores() == std::vector<uint32_t>{0, 1, 2, 3});
+  CHECK(topology.get_physical_cores(1) == std::vector<uint32_t>{2, 3});
+  CHECK(topology.get_logical_cpus(0) == std::vector<uint32_t>{0, 4, 1, 5});
+
+  // Missing sysfs falls back to a flat topology
+  auto flat = ouly::cpu_topology::detect("/nonexistent");
+  REQUIRE(!flat.get_cpus().empty());
+  CHECK(flat.get_node_count() == 1);
+
+  // Groups placed on the machine's own topology
+  auto machine = ouly::cpu_topology::detect();
+  auto cores   = machine.get_physical_cores();
+  REQUIRE(!cores.empty());
+
+  ouly::scheduler scheduler;
+  auto            offset = static_cast<uint32_t>(4 + cores.size());
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  scheduler.create_group(ouly::workgroup_id(1), 4, machine, cores);
+  scheduler.create_group(ouly::workgroup_id(2), offset, topology, topology.get_logical_cpus());
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t executed = 0;
+  for (uint32_t i = 0; i < 256; ++i)
+  {
+    for (uint32_t group = 1; group < 3; ++group)
+    {
+      scheduler.submit(ouly::main_worker_id, ouly::workgroup_id(group),
+                       [&executed](ouly::worker_context const&)
+                       {
+                         executed.fetch_add(1);
+                       });
+    }
+  }
+  scheduler.end_execution();
+  CHECK(executed.load() == 512);
+}
+
+TEST_CASE("scheduler: Trace export")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 2);
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t executed = 0;
+  auto const&          ctx      = ouly::worker_context::get(ouly::default_workgroup_id);
+  for (uint32_t i = 0; i < 64; ++i)
+  {
+    ouly::async(ctx, ouly::default_workgroup_id,
+                [&executed](ouly::worker_context const&)
+                {
+                  executed.fetch_add(1);
+                });
+  }
+  scheduler.end_execution();
+  CHECK(executed.load() == 64);
+
+  auto events = scheduler.drain_trace();
+#ifdef OULY_SCHEDULER_TRACE
+  auto count = [&](ouly::trace_event_type type)
+  {
+    return std::ranges::count(events, type, &ouly::trace_event::type_);
+  };
+  CHECK(count(ouly::trace_event_type::submit) == 64);
+  CHECK(count(ouly::trace_event_type::task_begin) == 64);
+  CHECK(count(ouly::trace_event_type::task_end) == 64);
+  CHECK(std::ranges::is_sorted(events, {}, &ouly::trace_event::timestamp_));
+  // Drained events are not returned again
+  CHECK(scheduler.drain_trace().empty());
+#else
+  CHECK(events.empty());
+#endif
+
+  std::ostringstream json;
+  ouly::write_chrome_trace(json, events);
+  auto text = json.str();
+  CHECK(text.starts_with(R"({"displayTimeUnit":"ns","traceEvents":[)"));
+  CHECK(text.ends_with("]}\n"));
+#ifdef OULY_SCHEDULER_TRACE
+  CHECK(text.find(R"("name":"group 0","cat":"task","ph":"B")") != std::string::npos);
+  CHECK(text.find(R"("name":"thread_name")") != std::string::npos);
+#endif
+}
+
+TEST_CASE("scheduler: Worker statistics")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 2);
+  auto other = scheduler.create_group(1, 1);
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t executed = 0;
+  auto const&          ctx      = ouly::worker_context::get(ouly::default_workgroup_id);
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    ouly::async(ctx, i % 4 == 0 ? other : ouly::default_workgroup_id,
+                [&executed](ouly::worker_context const&)
+                {
+                  executed.fetch_add(1);
+                });
+  }
+  for (uint32_t i = 0; i < 10; ++i)
+  {
+    ouly::async(ctx, ouly::worker_id(1), other,
+                [&executed](ouly::worker_context const&)
+                {
+                  executed.fetch_add(1);
+                });
+  }
+  while (executed.load() < 110)
+  {
+    scheduler.busy_work(ouly::main_worker_id);
+  }
+
+  // Can be read while workers are running
+  auto running = scheduler.collect_stats();
+  CHECK(running.workers.size() == 2);
+
+  scheduler.end_execution();
+
+  auto stats = scheduler.collect_stats();
+  REQUIRE(stats.workers.size() == 2);
+  auto total = stats.get_total();
+  REQUIRE(total.tasks_executed.size() == 2);
+  CHECK(total.tasks_executed[0] == 75);
+  CHECK(total.tasks_executed[1] == 35);
+  CHECK(total.get_tasks_executed() == 110);
+  // Group 1 only has worker 1
+  CHECK(stats.workers[0].tasks_executed[1] == 0);
+  CHECK(stats.workers[1].exclusive_pops == 10);
+  CHECK(total.local_pops + total.shared_pops + total.stolen_pops + total.exclusive_pops + total.local_work_hits == 110);
+  CHECK(total.idle.parks >= stats.workers[1].idle.parks);
+  CHECK(running.get_total().get_tasks_executed() <= total.get_tasks_executed());
+}
+
+TEST_CASE("scheduler: Timer wheel")
+{
+  ouly::detail::timer_wheel wheel;
+  wheel.reset(0);
+
+  // Deadlines spread over every level and beyond the wheel's range
+  std::minstd_rand                  rng(7);
+  std::vector<uint64_t>             deadlines;
+  std::vector<uint64_t>             fired_at;
+  std::vector<ouly::timer_id>       ids;
+  constexpr uint64_t                far = uint64_t{1} << 26U;
+  std::uniform_int_distribution<uint64_t> dist(1, far);
+  for (uint32_t i = 0; i < 512; ++i)
+  {
+    auto deadline = i < 64 ? i + 1 : dist(rng);
+    deadlines.push_back(deadline);
+    fired_at.push_back(0);
+    ids.push_back(wheel.add(ouly::detail::work_item::pbind(
+                             [](ouly::worker_context const&)
+                             {
+                             },
+                             ouly::workgroup_id(i)),
+                            deadline, 0));
+  }
+  CHECK(wheel.size() == 512);
+
+  // Cancel a few, including one that is cancelled twice
+  CHECK(wheel.cancel(ids[3]));
+  CHECK(!wheel.cancel(ids[3]));
+  CHECK(wheel.cancel(ids[300]));
+
+  uint64_t now = 0;
+  while (wheel.size() > 0)
+  {
+    now += std::uniform_int_distribution<uint64_t>(1, 70000)(rng);
+    wheel.advance(now,
+                  [&](ouly::detail::work_item const& work)
+                  {
+                    auto index = work.get_compressed_data<ouly::workgroup_id>().get_index();
+                    CHECK(fired_at[index] == 0);
+                    fired_at[index] = now;
+                  });
+  }
+  for (uint32_t i = 0; i < 512; ++i)
+  {
+    if (i == 3 || i == 300)
+    {
+      CHECK(fired_at[i] == 0);
+      continue;
+    }
+    // Fired on the first advance that reached the deadline
+    CHECK(fired_at[i] >= deadlines[i]);
+    CHECK(fired_at[i] - deadlines[i] < 70000);
+  }
+  CHECK(wheel.next_deadline() == ouly::detail::timer_wheel::no_deadline);
+
+  // Periodic timers keep their phase and skip missed periods
+  uint32_t count    = 0;
+  auto     periodic = wheel.add(ouly::detail::work_item::pbind(
+                                 [](ouly::worker_context const&)
+                                 {
+                                 },
+                                 ouly::default_workgroup_id),
+                                now + 10, 10);
+  auto     fire     = [&](ouly::detail::work_item const&)
+  {
+    ++count;
+  };
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    wheel.advance(now + i + 1, fire);
+  }
+  CHECK(count == 10);
+  CHECK(wheel.advance(now + 1000, fire) == 1);
+  CHECK(wheel.next_deadline() == now + 1010);
+  CHECK(wheel.cancel(periodic));
+  CHECK(wheel.size() == 0);
+}
+
+TEST_CASE("scheduler: Delayed and periodic submission")
+{
+  ouly::scheduler_options options;
+  options.timer_tick = std::chrono::microseconds(50);
+  ouly::scheduler scheduler(options);
+  scheduler.create_group(ouly::default_workgroup_id, 0, 2);
+  scheduler.begin_execution();
+
+  using clock = std::chrono::steady_clock;
+  struct timer_state
+  {
+    clock::time_point       start_ = clock::now();
+    std::atomic_bool        delayed_done_ = false;
+    std::atomic<clock::rep> delayed_at_   = 0;
+  } state;
+  std::atomic_uint32_t ticks     = 0;
+  std::atomic_bool     cancelled = false;
+
+  scheduler.submit_after(std::chrono::milliseconds(5), ouly::default_workgroup_id,
+                         [&state](ouly::worker_context const&)
+                         {
+                           state.delayed_at_.store((clock::now() - state.start_).count());
+                           state.delayed_done_.store(true);
+                         });
+  auto never = scheduler.submit_after(std::chrono::milliseconds(1), ouly::default_workgroup_id,
+                                      [&cancelled](ouly::worker_context const&)
+                                      {
+                                        cancelled.store(true);
+                                      });
+  CHECK(scheduler.cancel_timer(never));
+  auto periodic = scheduler.submit_every(std::chrono::milliseconds(1), ouly::default_workgroup_id,
+                                         [&ticks](ouly::worker_context const&)
+                                         {
+                                           ticks.fetch_add(1);
+                                         });
+
+  // Worker 1 parks and has to wake up for the timers on its own
+  while (!state.delayed_done_.load() || ticks.load() < 5)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  CHECK(scheduler.cancel_timer(periodic));
+  CHECK(!scheduler.cancel_timer(periodic));
+  scheduler.end_execution();
+
+  CHECK(state.delayed_at_.load() >= std::chrono::duration_cast<clock::duration>(std::chrono::milliseconds(5)).count());
+  CHECK(!cancelled.load());
+}
+
+TEST_CASE("scheduler: Priority lanes")
+{
+  std::vector<char> order;
+  auto              run = [&order](uint32_t aging, std::string_view tags)
+  {
+    ouly::scheduler_options options;
+    options.priority_aging = aging;
+    ouly::scheduler scheduler(options);
+    scheduler.create_group(ouly::default_workgroup_id, 0, 1);
+    scheduler.begin_execution();
+    order.clear();
+    for (auto tag : tags)
+    {
+      scheduler.submit(
+       ouly::main_worker_id, ouly::default_workgroup_id,
+       [&order, tag](ouly::worker_context const&)
+       {
+         order.push_back(tag);
+       },
+       tag == 'h' ? ouly::task_priority::high : (tag == 'l' ? ouly::task_priority::low : ouly::task_priority::normal));
+    }
+    while (scheduler.busy_work(ouly::main_worker_id))
+    {
+    }
+    scheduler.end_execution();
+    return std::string(order.begin(), order.end());
+  };
+
+  // High preempts the worker's own queue, low waits for everything else
+  CHECK(run(0, "nlhnh") == "hhnnl");
+  // Aging takes the low lane on every 4th look for work even with normal work pending
+  CHECK(run(4, "lnnnnnnnn") == "nnnlnnnnn");
+
+  // Prioritized work is not lost with several workers
+  ouly::scheduler multi;
+  multi.create_group(ouly::default_workgroup_id, 0, 3);
+  multi.begin_execution();
+  std::atomic_uint32_t executed = 0;
+  for (uint32_t i = 0; i < 300; ++i)
+  {
+    multi.submit(
+     ouly::main_worker_id, ouly::default_workgroup_id,
+     [&executed](ouly::worker_context const&)
+     {
+       executed.fetch_add(1);
+     },
+     static_cast<ouly::task_priority>(i % ouly::task_priority_count));
+  }
+  multi.end_execution();
+  CHECK(executed.load() == 300);
+}
+
+TEST_CASE("scheduler: Resize group at runtime")
+{
+  ouly::scheduler scheduler;
+  auto            loading = ouly::workgroup_id(1);
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  // Only the main thread serves the group, nothing it queues runs until the group is moved
+  scheduler.create_group(loading, 0, 1);
+  scheduler.begin_execution();
+
+  std::array<std::atomic_uint32_t, 4> ran_on{};
+  auto                                record = [&ran_on](ouly::worker_context const& ctx)
+  {
+    ran_on[ctx.get_worker().get_index()].fetch_add(1);
+  };
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    scheduler.submit(ouly::main_worker_id, loading, record, i % 4 == 0 ? ouly::task_priority::high
+                                                                      : ouly::task_priority::normal);
+  }
+
+  scheduler.resize_group(loading, 2, 2);
+  scheduler.set_group_priority(loading, 3);
+  CHECK(scheduler.get_worker_start_idx(loading) == 2);
+  CHECK(scheduler.get_worker_count(loading) == 2);
+  CHECK(scheduler.get_context(ouly::worker_id(3), loading).belongs_to(loading));
+  CHECK(scheduler.get_context(ouly::worker_id(3), loading).get_group_offset() == 1);
+  CHECK(!scheduler.get_context(ouly::main_worker_id, loading).belongs_to(loading));
+
+  // Items queued before the resize are moved to the new workers, new items go there too
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    scheduler.submit(ouly::main_worker_id, loading, record);
+  }
+  std::atomic_uint32_t other = 0;
+  ouly::parallel_for(
+   [&other](int a, int b, ouly::worker_context const&)
+   {
+     other.fetch_add(static_cast<uint32_t>(b - a));
+   },
+   ouly::integer_range(0, 256), ouly::default_workgroup_id);
+
+  scheduler.resize_group(ouly::default_workgroup_id, 0, 2);
+
+  // Items handed to sleeping workers that leave the group before they woke up run on the new workers
+  struct
+  {
+    std::atomic_uint32_t handed_off  = 0;
+    std::atomic_uint32_t wrong_group = 0;
+  } handoffs;
+  for (uint32_t round = 0; round < 20; ++round)
+  {
+    scheduler.resize_group(loading, 1, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+      scheduler.submit(ouly::main_worker_id, loading,
+                       [&handoffs, loading](ouly::worker_context const& ctx)
+                       {
+                         if (!ctx.belongs_to(loading))
+                         {
+                           handoffs.wrong_group.fetch_add(1);
+                         }
+                         handoffs.handed_off.fetch_add(1);
+                       });
+    }
+    scheduler.resize_group(loading, 3, 1);
+  }
+  scheduler.end_execution();
+
+  CHECK(other.load() == 256);
+  CHECK(ran_on[0].load() == 0);
+  CHECK(ran_on[1].load() == 0);
+  CHECK(ran_on[2].load() + ran_on[3].load() == 200);
+  CHECK(handoffs.handed_off.load() == 40);
+  CHECK(handoffs.wrong_group.load() == 0);
+}
+
+TEST_CASE("scheduler: Elastic parking")
+{
+  ouly::scheduler_options options;
+  options.elastic.enabled        = true;
+  options.elastic.min_active     = 1;
+  options.elastic.wake_threshold = 8;
+  ouly::scheduler scheduler(options);
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  scheduler.begin_execution();
+
+  auto all_parked = [&scheduler]()
+  {
+    for (uint32_t w = 1; w < 4; ++w)
+    {
+      while (scheduler.get_idle_stats(ouly::worker_id(w)).parks == 0)
+      {
+        std::this_thread::yield();
+      }
+    }
+  };
+  all_parked();
+
+  std::array<std::atomic_uint32_t, 4> ran_on{};
+  std::atomic_uint32_t                done   = 0;
+  auto                                record = [&ran_on, &done](ouly::worker_context const& ctx)
+  {
+    ran_on[ctx.get_worker().get_index()].fetch_add(1);
+    done.fetch_add(1);
+  };
+
+  // A few items at a time never build a backlog, the first worker is the only one woken up
+  for (uint32_t round = 0; round < 16; ++round)
+  {
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+      scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, record);
+    }
+    while (done.load() != (round + 1) * 4)
+    {
+      std::this_thread::yield();
+    }
+  }
+  CHECK(ran_on[1].load() == 64);
+
+  // Bursts and external submits are not lost
+  for (uint32_t i = 0; i < 1000; ++i)
+  {
+    scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, record);
+  }
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    scheduler.submit_external(ouly::default_workgroup_id,
+                              ouly::detail::work_item::pbind(record, ouly::default_workgroup_id));
+  }
+  scheduler.submit_batch(ouly::main_worker_id, ouly::default_workgroup_id, 100,
+                         [&record](uint32_t)
+                         {
+                           return ouly::detail::work_item::pbind(record, ouly::default_workgroup_id);
+                         });
+  while (done.load() != 1264)
+  {
+    std::this_thread::yield();
+  }
+  scheduler.end_execution();
+  CHECK(ran_on[0].load() == 0);
+}
+
+ouly::co_task<uint32_t> never_runs(std::atomic_bool& ran)
+{
+  ran = true;
+  co_return 42;
+}
+
+ouly::co_task<uint32_t> await_cancelled(ouly::scheduler& s, ouly::cancellation_token token, std::atomic_bool& ran)
+{
+  auto child = never_runs(ran);
+  s.submit(ouly::worker_id::get(), ouly::default_workgroup_id, token, child);
+  auto value = co_await child;
+  co_return child.is_cancelled() ? value + 1 : 0;
+}
+
+TEST_CASE("scheduler: Cancellation")
+{
+  ouly::scheduler scheduler;
+  auto            frame = ouly::workgroup_id(1);
+  scheduler.create_group(ouly::default_workgroup_id, 0, 2);
+  // Only the main thread serves the group, queued items wait for busy_work
+  scheduler.create_group(frame, 0, 1);
+  scheduler.begin_execution();
+
+  std::atomic_uint32_t     executed = 0;
+  ouly::cancellation_source stale;
+  ouly::cancellation_source current;
+  CHECK(stale.get_token().can_be_cancelled());
+  CHECK(!ouly::cancellation_token{}.can_be_cancelled());
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    scheduler.submit(ouly::main_worker_id, frame, (i % 2) != 0 ? stale.get_token() : current.get_token(),
+                     [&executed](ouly::worker_context const&)
+                     {
+                       executed.fetch_add(1);
+                     });
+  }
+  stale.cancel();
+  CHECK(stale.is_cancelled());
+  CHECK(!current.is_cancelled());
+  while (scheduler.busy_work(ouly::main_worker_id))
+  {
+  }
+  CHECK(executed.load() == 50);
+
+  // A cancelled co_task completes right away, whoever awaits it resumes
+  std::atomic_bool ran = false;
+  auto             task = await_cancelled(scheduler, stale.get_token(), ran);
+  scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, task);
+  CHECK(task.sync_wait_result() == 1);
+  CHECK(!ran.load());
+
+  auto direct = never_runs(ran);
+  scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, stale.get_token(), direct);
+  CHECK(direct.sync_wait_result() == 0);
+  CHECK(direct.is_cancelled());
+  CHECK(direct.is_done());
+
+  stale.reset();
+  auto live = never_runs(ran);
+  scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, stale.get_token(), live);
+  CHECK(live.sync_wait_result() == 42);
+  CHECK(!live.is_cancelled());
+  CHECK(ran.load());
+
+  scheduler.end_execution();
+}
+
+struct serial_sort_traits
+{
+  static constexpr uint32_t parallel_execution_threshold = 1000;
+};
+
+TEST_CASE("scheduler: Parallel sort")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 8);
+  scheduler.begin_execution();
+
+  constexpr uint32_t    nb_elements = 100003;
+  std::mt19937          gen(42);
+  std::vector<uint32_t> keys(nb_elements);
+  for (auto& k : keys)
+  {
+    k = gen() % 5000;
+  }
+
+  SECTION("sort")
+  {
+    auto expected = keys;
+    std::sort(expected.begin(), expected.end());
+
+    auto result = keys;
+    ouly::parallel_sort(std::span(result), std::less<>(), ouly::default_workgroup_id);
+    CHECK(result == expected);
+
+    // Scratch kept across calls, uneven batches
+    std::vector<uint32_t> scratch(nb_elements);
+    result = keys;
+    ouly::parallel_sort(std::span(result), scratch, std::less<>(), ouly::default_workgroup_id, small_batches{});
+    CHECK(result == expected);
+
+    std::sort(expected.begin(), expected.end(), std::greater<>());
+    ouly::parallel_sort(std::span(result), scratch, std::greater<>(), ouly::default_workgroup_id);
+    CHECK(result == expected);
+
+    // Serial path
+    std::vector<uint32_t> few = {5, 3, 9, 1};
+    ouly::parallel_sort(std::span(few), std::less<>(), ouly::default_workgroup_id);
+    CHECK(few == std::vector<uint32_t>{1, 3, 5, 9});
+  }
+
+  SECTION("stable sort")
+  {
+    std::vector<std::pair<uint32_t, uint32_t>> items(nb_elements);
+    for (uint32_t i = 0; i < nb_elements; ++i)
+    {
+      items[i] = {keys[i] % 100, i};
+    }
+    auto by_key = [](auto const& l, auto const& r)
+    {
+      return l.first < r.first;
+    };
+
+    auto expected = items;
+    std::stable_sort(expected.begin(), expected.end(), by_key);
+
+    auto result = items;
+    ouly::parallel_stable_sort(std::span(result), by_key, ouly::default_workgroup_id);
+    CHECK(result == expected);
+
+    std::vector<std::pair<uint32_t, uint32_t>> scratch(nb_elements);
+    result = items;
+    ouly::parallel_stable_sort(std::span(result), scratch, by_key, ouly::default_workgroup_id, small_batches{});
+    CHECK(result == expected);
+
+    // Serial path, longer than one insertion sorted run
+    auto few          = std::vector(items.begin(), items.begin() + 100);
+    auto few_expected = few;
+    std::stable_sort(few_expected.begin(), few_expected.end(), by_key);
+    ouly::parallel_stable_sort(std::span(few), scratch, by_key, ouly::default_workgroup_id, serial_sort_traits{});
+    CHECK(few == few_expected);
+  }
+
+  scheduler.end_execution();
+}
+
+TEST_CASE("scheduler: Pipeline")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  auto sink_group = scheduler.create_group(2, 2);
+  scheduler.begin_execution();
+
+  constexpr uint32_t max_tokens = 4;
+  constexpr uint32_t item_count = 1000;
+
+  std::array<uint32_t, max_tokens> items{};
+  std::vector<uint32_t>            output;
+  std::atomic_uint32_t             in_flight     = 0;
+  std::atomic_uint32_t             max_in_flight = 0;
+  std::atomic_uint32_t             in_serial     = 0;
+  std::atomic_uint32_t             overlaps      = 0;
+  std::atomic_uint64_t             serial_sum    = 0;
+  std::atomic_uint32_t             wrong_group   = 0;
+  uint32_t                         next_item     = 0;
+
+  ouly::pipeline pipe(max_tokens);
+  pipe.set_input(ouly::default_workgroup_id,
+                 [&](uint32_t token, ouly::worker_context const&)
+                 {
+                   if (next_item == item_count)
+                   {
+                     return false;
+                   }
+                   items[token] = next_item++;
+                   auto count   = in_flight.fetch_add(1) + 1;
+                   auto seen    = max_in_flight.load();
+                   while (count > seen && !max_in_flight.compare_exchange_weak(seen, count))
+                   {
+                   }
+                   return true;
+                 });
+  pipe.add_stage(ouly::stage_mode::parallel, ouly::default_workgroup_id,
+                 [&](uint32_t token, ouly::worker_context const&)
+                 {
+                   items[token] *= 3;
+                 });
+  pipe.add_stage(ouly::stage_mode::serial_out_of_order, ouly::default_workgroup_id,
+                 [&](uint32_t token, ouly::worker_context const&)
+                 {
+                   if (in_serial.fetch_add(1) != 0)
+                   {
+                     overlaps++;
+                   }
+                   serial_sum += items[token];
+                   in_serial.fetch_sub(1);
+                 });
+  pipe.add_stage(ouly::stage_mode::serial_in_order, sink_group,
+                 [&](uint32_t token, ouly::worker_context const& ctx)
+                 {
+                   if (!ctx.belongs_to(sink_group))
+                   {
+                     wrong_group++;
+                   }
+                   output.push_back(items[token]);
+                   in_flight.fetch_sub(1);
+                 });
+  CHECK(pipe.get_stage_count() == 3);
+
+  std::vector<uint32_t> expected(item_count);
+  for (uint32_t i = 0; i < item_count; ++i)
+  {
+    expected[i] = i * 3;
+  }
+
+  // A finished pipeline runs again
+  for (uint32_t round = 0; round < 2; ++round)
+  {
+    output.clear();
+    serial_sum = 0;
+    next_item  = 0;
+    pipe.run(ouly::worker_context::get(ouly::default_workgroup_id));
+    CHECK(output == expected);
+    CHECK(serial_sum.load() == uint64_t{3} * item_count * (item_count - 1) / 2);
+  }
+  CHECK(overlaps.load() == 0);
+  CHECK(max_in_flight.load() <= max_tokens);
+  CHECK(in_flight.load() == 0);
+  CHECK(wrong_group.load() == 0);
+
+  // No input at all
+  ouly::pipeline empty(2);
+  empty.set_input(ouly::default_workgroup_id,
+                  [](uint32_t, ouly::worker_context const&)
+                  {
+                    return false;
+                  });
+  empty.add_stage(ouly::stage_mode::parallel, ouly::default_workgroup_id, [](uint32_t, ouly::worker_context const&) {});
+  empty.run(ouly::worker_context::get(ouly::default_workgroup_id));
+
+  scheduler.end_execution();
+}
+
+void fork_join_fib(ouly::worker_context const& ctx, uint32_t n, uint64_t& result)
+{
+  if (n < 2)
+  {
+    result = n;
+    return;
+  }
+  uint64_t         a = 0;
+  uint64_t         b = 0;
+  ouly::task_group children(ctx.get_workgroup());
+  children.run(ctx,
+               [n, &a](ouly::worker_context const& wc)
+               {
+                 fork_join_fib(wc, n - 1, a);
+               });
+  children.run(ctx,
+               [n, &b](ouly::worker_context const& wc)
+               {
+                 fork_join_fib(wc, n - 2, b);
+               });
+  children.wait(ctx);
+  result = a + b;
+}
+
+TEST_CASE("scheduler: Task group")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  auto remote = scheduler.create_group(1, 2);
+  scheduler.begin_execution();
+
+  auto const& ctx = ouly::worker_context::get(ouly::default_workgroup_id);
+
+  // Nested fork/join, every level waits on its own children
+  uint64_t fib = 0;
+  fork_join_fib(ctx, 18, fib);
+  CHECK(fib == 2584);
+
+  // Waiting without children returns at once
+  {
+    ouly::task_group empty;
+    empty.wait(ctx);
+  }
+
+  // The main thread is not a worker of the remote group, it waits while the group's workers run the children
+  std::atomic_uint32_t count       = 0;
+  std::atomic_uint32_t wrong_group = 0;
+  ouly::task_group     children(remote);
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    children.run(ctx,
+                 [&count, &wrong_group, remote](ouly::worker_context const& wc)
+                 {
+                   if (!wc.belongs_to(remote))
+                   {
+                     wrong_group++;
+                   }
+                   count++;
+                 });
+  }
+  children.wait(ctx);
+  CHECK(count.load() == 100);
+  CHECK(wrong_group.load() == 0);
+
+  // Reused after a wait
+  children.run(ctx,
+               [&count](ouly::worker_context const&)
+               {
+                 count++;
+               });
+  children.wait(ctx);
+  CHECK(count.load() == 101);
+
+  scheduler.end_execution();
+}
+
+ouly::co_task<void> locked_increment(ouly::async_mutex& mutex, uint32_t& counter, std::atomic_uint32_t& inside,
+                                     std::atomic_uint32_t& overlaps)
+{
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    auto guard = co_await mutex.scoped_lock();
+    if (inside.fetch_add(1) != 0)
+    {
+      overlaps++;
+    }
+    counter++;
+    inside.fetch_sub(1);
+  }
+}
+
+ouly::co_task<void> limited_section(ouly::async_semaphore& semaphore, std::atomic_uint32_t& inside,
+                                    std::atomic_uint32_t& over_limit)
+{
+  co_await semaphore.acquire();
+  if (inside.fetch_add(1) >= 2)
+  {
+    over_limit++;
+  }
+  inside.fetch_sub(1);
+  semaphore.release();
+}
+
+ouly::co_task<uint32_t> wait_latch(ouly::async_latch& latch, std::atomic_uint32_t& done)
+{
+  co_await latch.wait();
+  co_return done.load();
+}
+
+ouly::co_task<void> wait_event(ouly::async_event& event, std::atomic_uint32_t& resumed)
+{
+  co_await event.wait();
+  resumed++;
+}
+
+ouly::co_task<void> read_or_write(ouly::async_shared_mutex& mutex, uint32_t index, uint32_t& value,
+                                  std::atomic_uint32_t& readers, std::atomic_uint32_t& violations)
+{
+  if (index % 4 == 0)
+  {
+    auto guard = co_await mutex.scoped_lock();
+    if (readers.load() != 0)
+    {
+      violations++;
+    }
+    value++;
+  }
+  else
+  {
+    auto guard = co_await mutex.scoped_lock_shared();
+    readers++;
+    (void)value;
+    readers--;
+  }
+}
+
+TEST_CASE("scheduler: Async synchronization")
+{
+  ouly::scheduler scheduler;
+  scheduler.create_group(ouly::default_workgroup_id, 0, 4);
+  scheduler.begin_execution();
+
+  // Contended critical sections, waiters are suspended and handed the lock in turn
+  {
+    ouly::async_mutex                mutex(scheduler);
+    uint32_t                         counter  = 0;
+    std::atomic_uint32_t             inside   = 0;
+    std::atomic_uint32_t             overlaps = 0;
+    std::vector<ouly::co_task<void>> tasks;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+      tasks.emplace_back(locked_increment(mutex, counter, inside, overlaps));
+      scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, tasks.back());
+    }
+    for (auto& task : tasks)
+      task.sync_wait_result(ouly::main_worker_id, scheduler);
+    CHECK(counter == 1600);
+    CHECK(overlaps.load() == 0);
+    CHECK(mutex.try_lock());
+    CHECK(!mutex.try_lock());
+    mutex.unlock();
+  }
+
+  {
+    ouly::async_semaphore            semaphore(scheduler, 2);
+    std::atomic_uint32_t             inside     = 0;
+    std::atomic_uint32_t             over_limit = 0;
+    std::vector<ouly::co_task<void>> tasks;
+    for (uint32_t i = 0; i < 32; ++i)
+    {
+      tasks.emplace_back(limited_section(semaphore, inside, over_limit));
+      scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, tasks.back());
+    }
+    for (auto& task : tasks)
+      task.sync_wait_result(ouly::main_worker_id, scheduler);
+    CHECK(over_limit.load() == 0);
+    CHECK(semaphore.get_count() == 2);
+  }
+
+  // Waiters queued before the count reaches 0 resume afterwards
+  {
+    ouly::async_latch                    latch(scheduler, 3);
+    std::atomic_uint32_t                 done = 0;
+    std::vector<ouly::co_task<uint32_t>> waiters;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+      waiters.emplace_back(wait_latch(latch, done));
+      scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, waiters.back());
+    }
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+      done++;
+      latch.count_down();
+    }
+    for (auto& waiter : waiters)
+      CHECK(waiter.sync_wait_result(ouly::main_worker_id, scheduler) == 3);
+    CHECK(latch.try_wait());
+  }
+
+  {
+    ouly::async_event                event(scheduler);
+    std::atomic_uint32_t             resumed = 0;
+    std::vector<ouly::co_task<void>> waiters;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+      waiters.emplace_back(wait_event(event, resumed));
+      scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, waiters.back());
+    }
+    CHECK(!event.is_set());
+    event.set();
+    for (auto& waiter : waiters)
+      waiter.sync_wait_result(ouly::main_worker_id, scheduler);
+    CHECK(resumed.load() == 4);
+    event.reset();
+    CHECK(!event.is_set());
+  }
+
+  {
+    ouly::async_shared_mutex         mutex(scheduler);
+    uint32_t                         value      = 0;
+    std::atomic_uint32_t             readers    = 0;
+    std::atomic_uint32_t             violations = 0;
+    std::vector<ouly::co_task<void>> tasks;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+      tasks.emplace_back(read_or_write(mutex, i, value, readers, violations));
+      scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, tasks.back());
+    }
+    for (auto& task : tasks)
+      task.sync_wait_result(ouly::main_worker_id, scheduler);
+    CHECK(value == 16);
+    CHECK(violations.load() == 0);
+    CHECK(mutex.try_lock_shared());
+    CHECK(!mutex.try_lock());
+    mutex.unlock_shared();
+  }
+
+  scheduler.end_execution();
+}
+
+#ifndef _WIN32
+ouly::co_task<uint32_t> copy_through_file(ouly::io_service& io, int fd, ouly::workgroup_id group)
+{
+  std::array<std::byte, 1024> out{};
+  for (std::size_t i = 0; i < out.size(); ++i)
+  {
+    out[i] = static_cast<std::byte>(i * 7);
+  }
+  uint32_t checks  = 0;
+  auto     written = co_await ouly::async_write(io, fd, out, 512, group);
+  checks += (written && written.bytes_ == out.size()) ? 1 : 0;
+  checks += ouly::worker_context::get(group).belongs_to(group) ? 1 : 0;
+
+  std::array<std::byte, 1024> in{};
+  auto                        read = co_await ouly::async_read(io, fd, in, 512, group);
+  checks += (read && read.bytes_ == in.size() && in == out) ? 1 : 0;
+
+  // Short read at the end of the file
+  auto tail = co_await ouly::async_read(io, fd, in, 1024);
+  checks += (tail && tail.bytes_ == 512) ? 1 : 0;
+
+  auto failed = co_await ouly::async_read(io, -1, in, 0, group);
+  checks += (!failed && failed.error_ == EBADF) ? 1 : 0;
+  co_return checks;
+}
+
+TEST_CASE("scheduler: Async file io")
+{
+  // Unique per run, parallel test runs must not share the file
+  auto name = (std::filesystem::temp_directory_path() / "ouly_async_file_io_XXXXXX").string();
+  int  created = ::mkstemp(name.data());
+  REQUIRE(created >= 0);
+  ::close(created);
+  auto path = std::filesystem::path(name);
+  for (auto backend : {ouly::io_backend::automatic, ouly::io_backend::thread_pool})
+  {
+    ouly::scheduler scheduler;
+    auto            io_group = ouly::workgroup_id(1);
+    scheduler.create_group(ouly::default_workgroup_id, 0, 2);
+    scheduler.create_group(io_group, 2, 1);
+    scheduler.begin_execution();
+    {
+      int fd = ::open(path.c_str(), O_RDWR | O_TRUNC);
+      REQUIRE(fd >= 0);
+
+      ouly::io_service io(scheduler, {.backend = backend});
+      CHECK(io.get_backend() != ouly::io_backend::automatic);
+      CHECK(&ouly::io_service::get_default() == &io);
+
+      auto task = copy_through_file(io, fd, io_group);
+      scheduler.submit(ouly::main_worker_id, ouly::default_workgroup_id, task);
+      CHECK(task.sync_wait_result() == 5);
+      ::close(fd);
+    }
+    scheduler.end_execution();
+  }
+  std::filesystem::remove(path);
+}
+#endif
 // NOLINTEND
\ No newline at end of file